@@ -0,0 +1,156 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cstream.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+namespace {
+
+template <typename Function>
+double seconds(Function f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void report(const char *name, double time, std::size_t count)
+{
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(10) << std::right << time << " s "
+              << std::setw(10) << count / time / 1e6 << " M/s\n";
+}
+
+} // anonymous namespace
+
+/** Writes a solution vector and the costs of a model, as the solvers and
+ * mitm dump them, through cstream and through the std::to_string()
+ * conversions it used before.
+ */
+int main(int argc, char *argv[])
+{
+    std::size_t n = 1000000;
+    const char *filename = "/dev/null";
+    int option;
+
+    while ((option = ::getopt(argc, argv, "n:f:")) != -1) {
+        switch (option) {
+        case 'n':
+            n = std::stoul(::optarg);
+            break;
+        case 'f':
+            filename = ::optarg;
+            break;
+        }
+    }
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> bit(0, 1);
+    std::uniform_int_distribution<long> index(0, 100000000);
+    std::uniform_real_distribution<double> cost(-100, 100);
+
+    std::vector<int> x(n);
+    std::vector<long> indices(n);
+    std::vector<double> c(n);
+    for (std::size_t i = 0; i != n; ++i) {
+        x[i] = bit(gen);
+        indices[i] = index(gen);
+        c[i] = cost(gen);
+    }
+
+    const int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "fail to open " << filename << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << n << " values to " << filename << '\n' << std::fixed
+              << std::setprecision(3);
+
+    {
+        mitm::cstream cs(fd, false);
+
+        report("cstream << int", seconds(
+                   [&]()
+                   {
+                       for (int value : x)
+                           cs << value << ' ';
+                       cs.flush();
+                   }), n);
+
+        report("cstream << long", seconds(
+                   [&]()
+                   {
+                       for (long value : indices)
+                           cs << value << ' ';
+                       cs.flush();
+                   }), n);
+
+        report("cstream << double", seconds(
+                   [&]()
+                   {
+                       for (double value : c)
+                           cs << value << ' ';
+                       cs.flush();
+                   }), n);
+
+        report("cstream printf double", seconds(
+                   [&]()
+                   {
+                       for (double value : c)
+                           cs.printf("%f ", value);
+                       cs.flush();
+                   }), n);
+
+        report("std::to_string long", seconds(
+                   [&]()
+                   {
+                       for (long value : indices)
+                           cs << std::to_string(value) << ' ';
+                       cs.flush();
+                   }), n);
+
+        report("std::to_string double", seconds(
+                   [&]()
+                   {
+                       for (double value : c)
+                           cs << std::to_string(value) << ' ';
+                       cs.flush();
+                   }), n);
+    }
+
+    ::close(fd);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mitm/mitm.hpp>
+#include "text-chunks.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <getopt.h>
+
+namespace {
+
+/// Write a random model of @e m constraints and @e n variables in the text
+/// format, with a comment line every row.
+void write_model(const std::string &filename, mitm::index m, mitm::index n,
+                 unsigned seed)
+{
+    std::ofstream ofs(filename);
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution nonzero(0.1);
+    std::uniform_real_distribution<mitm::real> cost(-100, 100);
+
+    ofs << "0 # dense random model for bench-io\n" << m << ' ' << n << '\n';
+
+    for (mitm::index i = 0; i != m; ++i) {
+        ofs << "# row " << i << '\n';
+        for (mitm::index j = 0; j != n; ++j)
+            ofs << nonzero(gen) << (j + 1 == n ? '\n' : ' ');
+    }
+
+    for (mitm::index i = 0; i != m; ++i)
+        ofs << 1 << (i + 1 == m ? '\n' : ' ');
+
+    ofs << std::setprecision(9);
+    for (mitm::index j = 0; j != n; ++j)
+        ofs << cost(gen) << (j + 1 == n ? '\n' : ' ');
+}
+
+/// Write @e s in the sparse text format of the rows.
+void write_rows(const std::string &filename, const mitm::SparseState &s)
+{
+    std::ofstream ofs(filename);
+
+    ofs << "1 # rows random model for bench-io\n" << s.constraints() << ' '
+        << s.variables() << '\n';
+
+    for (mitm::index i = 0; i != s.constraints(); ++i) {
+        ofs << s.rows_ptr[i + 1] - s.rows_ptr[i];
+        for (mitm::index k = s.rows_ptr[i]; k != s.rows_ptr[i + 1]; ++k)
+            ofs << ' ' << s.cols_index[k];
+        ofs << '\n';
+    }
+
+    for (int value : s.b)
+        ofs << value << ' ';
+    ofs << '\n' << std::setprecision(9);
+
+    for (mitm::real value : s.c)
+        ofs << value << ' ';
+    ofs << '\n';
+}
+
+template <typename Function>
+double seconds(Function f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    mitm::index m = 2000;
+    mitm::index n = 10000;
+    std::string filename = "bench-io-model.txt";
+    int option;
+
+    while ((option = ::getopt(argc, argv, "m:n:f:")) != -1) {
+        switch (option) {
+        case 'm':
+            m = std::stol(::optarg);
+            break;
+        case 'n':
+            n = std::stol(::optarg);
+            break;
+        case 'f':
+            filename = ::optarg;
+            break;
+        }
+    }
+
+    write_model(filename, m, n, 1234);
+
+    std::ifstream size_of(filename, std::ios::binary | std::ios::ate);
+    const double megabytes = static_cast<double>(size_of.tellg()) / 1e6;
+
+    mitm::SimpleState stream_state, load_state;
+
+    const double stream_time = seconds(
+        [&]()
+        {
+            // The stream operator reads the model after the format.
+            std::ifstream ifs(filename);
+            int format;
+            ifs >> format >> stream_state;
+        });
+
+    const double load_time = seconds(
+        [&]() { mitm::load(filename, load_state); });
+
+    // The same model in the binary format: mapping it only checks the
+    // header, the checksum reads all the arrays.
+    mitm::SparseState sparse_state;
+    const double sparse_time = seconds(
+        [&]() { mitm::load(filename, sparse_state); });
+
+    const std::string binary = filename + ".mitm";
+    mitm::save(binary, sparse_state);
+
+    std::unique_ptr<mitm::MappedState> mapped_state;
+    const double mapped_time = seconds(
+        [&]() { mapped_state.reset(new mitm::MappedState(binary)); });
+
+    bool verified = false;
+    const double verify_time = seconds(
+        [&]() { verified = mapped_state->verify(); });
+
+    // The format of the rows read in one chunk and in parallel chunks.
+    const std::string rows = filename + ".rows";
+    write_rows(rows, sparse_state);
+
+    std::ifstream rows_size_of(rows, std::ios::binary | std::ios::ate);
+    const double rows_megabytes =
+        static_cast<double>(rows_size_of.tellg()) / 1e6;
+
+    mitm::SparseState sequential_state, chunked_state;
+    const double sequential_time = seconds(
+        [&]()
+        {
+            mitm::load(rows, sequential_state, mitm::chunk_policy(1, 1u << 30));
+        });
+
+    const mitm::chunk_policy policy;
+    const double chunked_time = seconds(
+        [&]() { mitm::load(rows, chunked_state, policy); });
+
+    std::remove(filename.c_str());
+    std::remove(binary.c_str());
+    std::remove(rows.c_str());
+
+    if (sequential_state.cols_index != sparse_state.cols_index or
+        chunked_state.cols_index != sparse_state.cols_index or
+        chunked_state.c != sequential_state.c) {
+        std::cerr << "sequential and chunked load() read different models\n";
+        return EXIT_FAILURE;
+    }
+
+    if (not verified or
+        mapped_state->nonzeros() != sparse_state.nonzeros()) {
+        std::cerr << "save() and MappedState read different models\n";
+        return EXIT_FAILURE;
+    }
+
+    if (stream_state.a != load_state.a or stream_state.b != load_state.b or
+        stream_state.c != load_state.c) {
+        std::cerr << "operator>> and load() read different models\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "model " << m << " x " << n << ", " << std::fixed
+              << std::setprecision(3) << megabytes << " MB\n"
+              << std::setw(12) << std::left << "operator>>"
+              << std::setw(10) << std::right << stream_time << " s "
+              << std::setw(10) << megabytes / stream_time << " MB/s\n"
+              << std::setw(12) << std::left << "load"
+              << std::setw(10) << std::right << load_time << " s "
+              << std::setw(10) << megabytes / load_time << " MB/s\n"
+              << std::setw(12) << std::left << "load sparse"
+              << std::setw(10) << std::right << sparse_time << " s "
+              << std::setw(10) << megabytes / sparse_time << " MB/s\n"
+              << std::setw(12) << std::left << "mapped"
+              << std::setw(10) << std::right << mapped_time << " s\n"
+              << std::setw(12) << std::left << "checksum"
+              << std::setw(10) << std::right << verify_time << " s\n"
+              << "rows format, " << rows_megabytes << " MB, "
+              << policy.threads << " threads\n"
+              << std::setw(12) << std::left << "sequential"
+              << std::setw(10) << std::right << sequential_time << " s "
+              << std::setw(10) << rows_megabytes / sequential_time
+              << " MB/s\n"
+              << std::setw(12) << std::left << "chunked"
+              << std::setw(10) << std::right << chunked_time << " s "
+              << std::setw(10) << rows_megabytes / chunked_time << " MB/s\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mitm/mitm.hpp>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <getopt.h>
+
+namespace {
+
+/// Read the next token of an AssignmentProblem file (see
+/// tests/assignment_problem_input.conf), comments are skipped.
+template <typename Token>
+bool next_token(std::istream &is, Token& t) noexcept
+{
+    char current;
+
+    while (is.get(current)) {
+        switch (current) {
+        case '#':
+            while (is && is.get() != '\n');
+            break;
+
+        case '\n':
+        case ' ':
+        case '\t':
+        case '\r':
+            break;
+
+        default:
+            is.unget();
+            is >> t;
+            return not is.fail();
+        }
+    }
+
+    return false;
+}
+
+/// Build the X * X assignment problem: each task to one resource and each
+/// resource to one task.
+void assignment_init(mitm::SimpleState &state, mitm::index X)
+{
+    const mitm::index m = 2 * X;
+    const mitm::index n = X * X;
+
+    state.init(m, n);
+    std::fill(state.a.begin(), state.a.end(), false);
+
+    for (mitm::index i = 0; i != X; ++i) {
+        for (mitm::index j = 0; j != X; ++j) {
+            state.a[i * n + i * X + j] = true;
+            state.a[(m * n / 2) + (i * n) + i + (j * X)] = true;
+        }
+    }
+
+    std::fill(state.b.begin(), state.b.end(), 1);
+}
+
+struct instance
+{
+    std::string name;
+    mitm::SimpleState state;
+};
+
+std::vector<instance> read_instances(const char *filename)
+{
+    std::vector<instance> ret;
+    std::ifstream ifs(filename);
+    const char *basename = std::strrchr(filename, '/');
+    basename = basename ? basename + 1 : filename;
+    mitm::index X;
+
+    while (::next_token(ifs, X) and X > 0) {
+        ret.emplace_back();
+        ret.back().name = std::string(basename) + '#' +
+            std::to_string(ret.size());
+        assignment_init(ret.back().state, X);
+
+        for (auto& c : ret.back().state.c)
+            if (not ::next_token(ifs, c))
+                throw std::runtime_error("bad assignment problem file");
+    }
+
+    return ret;
+}
+
+instance random_instance(mitm::index X, unsigned seed)
+{
+    instance ret;
+    ret.name = "random-" + std::to_string(X) + '-' + std::to_string(seed);
+    assignment_init(ret.state, X);
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> dist(1, 20);
+    for (auto& c : ret.state.c)
+        c = dist(gen);
+
+    return ret;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    mitm::index limit = 1000;
+    int option;
+
+    while ((option = ::getopt(argc, argv, "l:")) != -1) {
+        switch (option) {
+        case 'l':
+            limit = std::stol(::optarg);
+            break;
+        }
+    }
+
+    std::vector<instance> instances = read_instances(
+        (::optind < argc) ? argv[::optind]
+        : EXAMPLES_DIR "/assignment_problem_input.conf");
+
+    for (unsigned seed = 1; seed != 4; ++seed) {
+        instances.emplace_back(random_instance(10, seed));
+        instances.emplace_back(random_instance(20, seed));
+    }
+
+    const mitm::schedule schedules[] = {
+        mitm::schedule::constant, mitm::schedule::geometric,
+        mitm::schedule::violation, mitm::schedule::annealing };
+    const char *names[] = { "constant", "geometric", "violation",
+                            "annealing" };
+
+    std::vector<std::string> lines;
+    for (const auto& elem : instances) {
+        std::ostringstream os;
+        os << std::setw(40) << std::left << elem.name;
+
+        for (auto policy : schedules) {
+            mitm::parameters p(0.01, 0.0001, 0.0001, policy);
+            auto start = std::chrono::steady_clock::now();
+
+            try {
+                auto r = mitm::heuristic_algorithm(elem.state, limit, p,
+                                                   std::string{});
+                auto end = std::chrono::steady_clock::now();
+
+                if (r.status != mitm::result_status::success)
+                    throw std::runtime_error("no solution found");
+
+                os << std::setw(8) << std::right << r.loop << " ("
+                   << std::setw(8) << std::chrono::duration_cast<
+                       std::chrono::microseconds>(end - start).count()
+                   << "us)";
+            } catch (const std::exception&) {
+                os << std::setw(8) << std::right << "-" << " ("
+                   << std::setw(8) << "-" << "us)";
+            }
+        }
+
+        lines.emplace_back(os.str());
+    }
+
+    std::cout << "\nLoops needed to find a solution (limit " << limit
+              << ")\n" << std::setw(40) << std::left << "instance";
+    for (auto name : names)
+        std::cout << std::setw(20) << std::right << name;
+    std::cout << '\n';
+
+    for (const auto& line : lines)
+        std::cout << line << '\n';
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_BIT_MATRIX_HPP
+#define FR_INRA_MITM_BIT_MATRIX_HPP
+
+#include <mitm/mitm.hpp>
+#include <cstdint>
+#include <vector>
+#include <cassert>
+#include "sparse-matrix.hpp"
+#include "bit-vector.hpp"
+
+namespace mitm {
+
+/** bit_matrix stores the non zero pattern of a matrix, one row of 64 bits
+ * words after the other. The product of a row and a bit_vector is an AND
+ * and a popcount per word.
+ */
+class bit_matrix
+{
+    using word_type = bit_vector::word_type;
+
+    std::vector<word_type> m_words;
+    index m_rows;
+    index m_cols;
+    index m_row_words;
+
+public:
+    bit_matrix() noexcept
+        : m_rows(0)
+        , m_cols(0)
+        , m_row_words(0)
+    {}
+
+    template <typename T, typename Index>
+    explicit bit_matrix(const sparse_matrix<T, Index> &A);
+
+    /// Rebuild from @e A, the words already allocated are reused.
+    template <typename T, typename Index>
+    void assign(const sparse_matrix<T, Index> &A);
+
+    /// Remove all the rows, the words remain allocated.
+    void clear() noexcept
+    {
+        m_words.clear();
+        m_rows = 0;
+        m_cols = 0;
+        m_row_words = 0;
+    }
+
+    /** Returns true if the bit rows of @e A use less memory than its CSR
+     * arrays, i.e. if the density of A is greater than about
+     * 8 / (8 * (sizeof(Index) + sizeof(T))).
+     */
+    template <typename T, typename Index>
+    static bool is_smaller(const sparse_matrix<T, Index> &A) noexcept
+    {
+        return static_cast<std::size_t>(A.rows()) *
+            bit_vector::words(A.cols()) * sizeof(word_type) <=
+            static_cast<std::size_t>(A.nonzeros()) *
+            (sizeof(Index) + sizeof(T));
+    }
+
+    bool empty() const noexcept
+    {
+        return m_words.empty();
+    }
+
+    index rows() const noexcept
+    {
+        return m_rows;
+    }
+
+    /// The number of bits set in both the row @e k and @e x.
+    int dot(index k, const bit_vector &x) const noexcept
+    {
+        assert(k >= 0 && k < m_rows && x.length() == m_cols);
+
+        const word_type *row = m_words.data() + k * m_row_words;
+        const word_type *words = x.data();
+        int ret = 0;
+
+        for (index w = 0; w != m_row_words; ++w)
+            ret += __builtin_popcountll(row[w] & words[w]);
+
+        return ret;
+    }
+
+    /// Memory used in bytes.
+    std::size_t size() const noexcept
+    {
+        return m_words.size() * sizeof(word_type);
+    }
+};
+
+template <typename T, typename Index>
+bit_matrix::bit_matrix(const sparse_matrix<T, Index> &A)
+    : bit_matrix()
+{
+    assign(A);
+}
+
+template <typename T, typename Index>
+void
+bit_matrix::assign(const sparse_matrix<T, Index> &A)
+{
+    m_rows = A.rows();
+    m_cols = A.cols();
+    m_row_words = bit_vector::words(A.cols());
+    m_words.assign(m_rows * m_row_words, 0);
+
+    for (index k = 0; k != m_rows; ++k) {
+        word_type *row = m_words.data() + k * m_row_words;
+
+        for (Index pos = A.row_begin(k), end = A.row_end(k); pos != end;
+             ++pos) {
+            const index j = A.column(pos);
+            row[j / bit_vector::word_bits] |=
+                word_type(1) << (j % bit_vector::word_bits);
+        }
+    }
+}
+
+}
+
+#endif
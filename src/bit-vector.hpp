@@ -0,0 +1,148 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_BIT_VECTOR_HPP
+#define FR_INRA_MITM_BIT_VECTOR_HPP
+
+#include <mitm/mitm.hpp>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <cassert>
+
+namespace mitm {
+
+/** bit_vector stores a 0/1 vector in 64 bits words.
+ *
+ * @code
+ * mitm::bit_vector x(n);
+ * x.set(j, 1);
+ * x.for_each(
+ *     [](mitm::index j) { std::cout << j << " is set\n"; });
+ * @endcode
+ */
+class bit_vector
+{
+public:
+    using word_type = std::uint64_t;
+    static constexpr index word_bits = 64;
+
+private:
+    std::vector<word_type> m_words;
+    index m_length;
+
+public:
+    /// Number of words needed to store @e length bits.
+    static index words(index length) noexcept
+    {
+        return (length + word_bits - 1) / word_bits;
+    }
+
+    bit_vector() noexcept
+        : m_length(0)
+    {}
+
+    explicit bit_vector(index length)
+        : m_words(words(length), 0)
+        , m_length(length)
+    {}
+
+    /// Reset to @e length bits set to zero, the words already allocated are
+    /// reused.
+    void assign(index length)
+    {
+        m_words.assign(words(length), 0);
+        m_length = length;
+    }
+
+    /// Number of bits.
+    index length() const noexcept
+    {
+        return m_length;
+    }
+
+    int operator[](index j) const noexcept
+    {
+        assert(j >= 0 && j < m_length);
+
+        return static_cast<int>((m_words[j / word_bits] >> (j % word_bits))
+                                & 1u);
+    }
+
+    void set(index j, int value) noexcept
+    {
+        assert(j >= 0 && j < m_length);
+
+        const word_type mask = word_type(1) << (j % word_bits);
+
+        if (value)
+            m_words[j / word_bits] |= mask;
+        else
+            m_words[j / word_bits] &= ~mask;
+    }
+
+    /// Number of bits set.
+    index count() const noexcept
+    {
+        index ret = 0;
+
+        for (auto word : m_words)
+            ret += __builtin_popcountll(word);
+
+        return ret;
+    }
+
+    /// Call @e f(j) for each bit j set, in increasing order.
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        for (index w = 0, e = static_cast<index>(m_words.size()); w != e;
+             ++w) {
+            for (word_type word = m_words[w]; word; word &= word - 1)
+                f(w * word_bits + __builtin_ctzll(word));
+        }
+    }
+
+    const word_type* data() const noexcept
+    {
+        return m_words.data();
+    }
+
+    /// Memory used in bytes.
+    std::size_t size() const noexcept
+    {
+        return m_words.size() * sizeof(word_type);
+    }
+
+    friend std::ostream&
+        operator<<(std::ostream &os, const bit_vector &x)
+        {
+            for (index j = 0; j != x.length(); ++j)
+                os << (j ? " " : "") << x[j];
+
+            return os;
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mitm/mitm.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+bool
+has_extension(const std::string &filename, const char *extension)
+{
+    const std::size_t length = std::strlen(extension);
+
+    return filename.size() > length and
+        filename.compare(filename.size() - length, length, extension) == 0;
+}
+
+}
+
+/** mitm-convert reads a model in one of the text formats of mitm::load()
+ * and writes it in the binary model format, mapped by the mitm program
+ * without parsing.
+ */
+int
+main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        std::cerr << "mitm-convert input output.mitm\n"
+                  << "Convert a text model (format 0, 1 or 2), a .mps or a "
+                  << ".lp file into a binary model.\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const std::string input(argv[1]);
+        mitm::SparseState state;
+
+        if (::has_extension(input, ".mps"))
+            mitm::load_mps(input, state);
+        else if (::has_extension(input, ".lp"))
+            mitm::load_lp(input, state);
+        else
+            mitm::load(input, state);
+
+        mitm::save(argv[2], state);
+
+        std::cout << argv[2] << ": " << state.constraints()
+                  << " constraints, " << state.variables() << " variables, "
+                  << state.nonzeros() << " non zero coefficients\n";
+    } catch (const std::exception &e) {
+        std::cerr << "/!\\ fail: " << argv[1] << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -23,9 +23,13 @@
 #include "cstream.hpp"
 #include <vector>
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 
 #ifdef __unix__
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -43,6 +47,46 @@ bool is_use_color_mode(int fd, bool try_color_mode) noexcept
 #endif
 }
 
+bool is_line_mode(int fd) noexcept
+{
+#ifdef __unix__
+    return fd == STDERR_FILENO or 1 == ::isatty(fd);
+#else
+    return true;
+#endif
+}
+
+bool is_regular_file(int fd) noexcept
+{
+#ifdef __unix__
+    struct stat st;
+
+    return ::fstat(fd, &st) == 0 and S_ISREG(st.st_mode);
+#else
+    return false;
+#endif
+}
+
+/// Writes all of @e buf, returns 0 or the errno of the failure.
+int write_all(int fd, const char *buf, std::size_t count) noexcept
+{
+    while (count > 0) {
+        const ssize_t n = ::write(fd, buf, count);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return errno;
+        }
+
+        buf += n;
+        count -= static_cast<std::size_t>(n);
+    }
+
+    return 0;
+}
+
 /// Find the length of a C array.
 template <class T, std::size_t N>
 std::size_t array_lenght(T (&)[N])
@@ -91,15 +135,6 @@ setter_to_str(mitm::cstream::setters s) noexcept
     return setters[static_cast<int>(s)];
 }
 
-void err_conversion_error(const char *what) noexcept
-{
-    mitm::err() << mitm::err().red()
-                << "stream conversion error "
-                << mitm::err().def()
-                << what
-                << "\n";
-}
-
 void err_write_error(int error_code) noexcept
 {
     std::vector<char>::size_type size {512};
@@ -152,6 +187,116 @@ void err_write_error(int error_code) noexcept
     }
 }
 
+/// The longest integer written by cstream, with its sign.
+const std::size_t integer_size = 21;
+
+/// The longest real written by format_fixed(): the %f format of DBL_MAX.
+const std::size_t real_size = 320;
+
+const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+
+/// Writes the digits of @e n before @e last, returns the first digit.
+char* format_digits(unsigned long long n, char *last) noexcept
+{
+    while (n >= 100) {
+        const unsigned pair = static_cast<unsigned>(n % 100) * 2;
+        n /= 100;
+        *--last = digit_pairs[pair + 1];
+        *--last = digit_pairs[pair];
+    }
+
+    if (n >= 10) {
+        const unsigned pair = static_cast<unsigned>(n) * 2;
+        *--last = digit_pairs[pair + 1];
+        *--last = digit_pairs[pair];
+    } else {
+        *--last = static_cast<char>('0' + n);
+    }
+
+    return last;
+}
+
+/// Writes @e n at @e first, returns the end.
+char* format_integer(unsigned long long n, bool negative, char *first)
+    noexcept
+{
+    char digits[integer_size];
+    char *last = digits + integer_size;
+    const char *begin = format_digits(n, last);
+
+    if (negative)
+        *first++ = '-';
+
+    std::memcpy(first, begin, static_cast<std::size_t>(last - begin));
+
+    return first + (last - begin);
+}
+
+template <typename Integer>
+char* format_signed(Integer n, char *first) noexcept
+{
+    const unsigned long long value = static_cast<unsigned long long>(n);
+
+    return format_integer(n < 0 ? 0ull - value : value, n < 0, first);
+}
+
+/** Writes @e value as std::printf("%f") at @e first, returns the end.
+ * The finite values below 2^64 are converted with exact integers: the
+ * value is m / 2^shift and the six decimals are rounded half to even
+ * like the C library. The others are left to std::snprintf.
+ */
+char* format_fixed(double value, char *first) noexcept
+{
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 uint128;
+
+    if (std::isfinite(value) and std::abs(value) < 18446744073709551616.0) {
+        if (std::signbit(value)) {
+            *first++ = '-';
+            value = -value;
+        }
+
+        int exponent;
+        const double mantissa = std::frexp(value, &exponent);
+        const std::uint64_t m = static_cast<std::uint64_t>(
+            std::ldexp(mantissa, 53));
+        const int shift = 53 - exponent;
+
+        std::uint64_t integer = 0, decimals = 0;
+
+        if (shift <= 0) {
+            integer = m << -shift;
+        } else if (shift < 128) {
+            const uint128 scaled = static_cast<uint128>(m) * 1000000u;
+            uint128 q = scaled >> shift;
+            const uint128 r = scaled - (q << shift);
+            const uint128 half = static_cast<uint128>(1) << (shift - 1);
+
+            if (r > half or (r == half and (q & 1u)))
+                ++q;
+
+            integer = static_cast<std::uint64_t>(q / 1000000u);
+            decimals = static_cast<std::uint64_t>(q % 1000000u);
+        }
+
+        first = format_integer(integer, false, first);
+        *first++ = '.';
+
+        for (char *last = first + 6; last != first; decimals /= 10)
+            *--last = static_cast<char>('0' + decimals % 10);
+
+        return first + 6;
+    }
+#endif
+
+    const int n = std::snprintf(first, real_size, "%f", value);
+
+    return n < 0 ? first : first + n;
+}
+
 } // anonymous namespace
 
 namespace mitm {
@@ -159,12 +304,39 @@ namespace mitm {
 cstream::cstream(int fd_, bool try_color_mode) noexcept
     : fd(fd_)
     , color_mode(::is_use_color_mode(fd, try_color_mode))
+    , line_mode(::is_line_mode(fd))
+    , used(0)
 {
 }
 
 cstream::~cstream() noexcept
 {
-    ::fsync(fd);
+    flush();
+
+    // A pipe or a terminal does not support fsync.
+    if (::is_regular_file(fd))
+        ::fsync(fd);
+}
+
+template <typename Function>
+cstream&
+cstream::put(std::size_t size, Function fn) noexcept
+{
+    int error = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (size > capacity - used)
+            error = flush_buffer();
+
+        used = static_cast<std::size_t>(fn(buffer + used) - buffer);
+    }
+
+    if (error and fd != STDERR_FILENO)
+        err_write_error(error);
+
+    return *this;
 }
 
 cstream&
@@ -200,89 +372,73 @@ cstream::operator<<(const std::string& str) noexcept
 cstream&
 cstream::operator<<(unsigned int n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_integer(n, false, first);
+               });
 }
 
 cstream&
 cstream::operator<<(signed int n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_signed(n, first);
+               });
 }
 
 cstream&
 cstream::operator<<(unsigned long n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_integer(n, false, first);
+               });
 }
 
 cstream&
 cstream::operator<<(signed long n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_signed(n, first);
+               });
 }
 
 cstream&
 cstream::operator<<(unsigned long long n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_integer(n, false, first);
+               });
 }
 
 cstream&
 cstream::operator<<(signed long long n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::integer_size, [n](char *first)
+               {
+                   return ::format_signed(n, first);
+               });
 }
 
 cstream&
 cstream::operator<<(double n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::real_size, [n](char *first)
+               {
+                   return ::format_fixed(n, first);
+               });
 }
 
 cstream&
 cstream::operator<<(float n) noexcept
 {
-    try {
-        return write(std::to_string(n));
-    } catch (const std::exception& e) {
-        err_conversion_error(e.what());
-        return *this;
-    }
+    return put(::real_size, [n](char *first)
+               {
+                   return ::format_fixed(n, first);
+               });
 }
 
 cstream&
@@ -306,28 +462,59 @@ cstream::printf(const char *format, ...) noexcept
 cstream&
 cstream::printf(const char *format, va_list ap) noexcept
 {
-    std::vector<char>::size_type size {100};
-    std::vector<char> buffer;
+    int error = 0;
+    int n;
 
-    for (;;) {
-        try {
-            buffer.resize(size);
-        } catch (const std::bad_alloc&) {
-            err() << red() << "stream printf error: bad alloc\n";
-            return *this;
+    {
+        // The text is formatted in the buffer, then again after a flush
+        // if it was too long for the space left.
+        std::lock_guard<std::mutex> lock(mutex);
+        va_list copy;
+
+        va_copy(copy, ap);
+        n = std::vsnprintf(buffer + used, capacity - used, format, copy);
+        va_end(copy);
+
+        if (n >= 0 and static_cast<std::size_t>(n) >= capacity - used) {
+            error = flush_buffer();
+
+            if (static_cast<std::size_t>(n) < capacity)
+                std::vsnprintf(buffer, capacity, format, ap);
         }
 
-        int n = std::vsnprintf(buffer.data(), size, format, ap);
-        if (n < 0) {
-            err() << red() <<  "stream printf error" << def() << "\n";
-            return *this;
+        if (n >= 0 and static_cast<std::size_t>(n) < capacity) {
+            const char *first = buffer + used;
+            used += static_cast<std::size_t>(n);
+
+            if (line_mode and std::memchr(first, '\n', n) and error == 0)
+                error = flush_buffer();
         }
+    }
+
+    if (error and fd != STDERR_FILENO)
+        err_write_error(error);
+
+    if (n < 0) {
+        err() << red() << "stream printf error" << def() << "\n";
+        return *this;
+    }
+
+    if (static_cast<std::size_t>(n) < capacity)
+        return *this;
 
-        if (static_cast<std::string::size_type>(n) < size)
-            return write(buffer.data(), n);
+    // Only the texts longer than the buffer are formatted on the heap.
+    std::vector<char> text;
 
-        size = static_cast<std::string::size_type>(n) + 1;
+    try {
+        text.resize(static_cast<std::size_t>(n) + 1);
+    } catch (const std::bad_alloc&) {
+        err() << red() << "stream printf error: bad alloc\n";
+        return *this;
     }
+
+    std::vsnprintf(text.data(), text.size(), format, ap);
+
+    return write(text.data(), static_cast<std::size_t>(n));
 }
 
 cstream&
@@ -335,13 +522,61 @@ cstream::write(const char *buf, std::size_t count) noexcept
 {
     assert(fd >= 0 && "file already closed");
 
-    if (buf != nullptr or count > 0)
-        if (::write(fd, buf, count) != static_cast<ssize_t>(count))
-            err_write_error(errno);
+    if (buf == nullptr or count == 0)
+        return *this;
+
+    int error = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (count > capacity - used)
+            error = flush_buffer();
+
+        if (count >= capacity) {
+            if (error == 0)
+                error = ::write_all(fd, buf, count);
+        } else {
+            std::memcpy(buffer + used, buf, count);
+            used += count;
+
+            if (line_mode and std::memchr(buf, '\n', count) and error == 0)
+                error = flush_buffer();
+        }
+    }
+
+    // The errors of the standard error are not reported on itself.
+    if (error and fd != STDERR_FILENO)
+        err_write_error(error);
+
+    return *this;
+}
+
+cstream&
+cstream::flush() noexcept
+{
+    int error;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = flush_buffer();
+    }
+
+    if (error and fd != STDERR_FILENO)
+        err_write_error(error);
 
     return *this;
 }
 
+int
+cstream::flush_buffer() noexcept
+{
+    const std::size_t count = used;
+    used = 0;
+
+    return ::write_all(fd, buffer, count);
+}
+
 cstream&
 cstream::set_modifier(modifier m) noexcept
 {
@@ -23,6 +23,7 @@
 #ifndef FR_INRA_MITM_CSTREAM_HPP
 #define FR_INRA_MITM_CSTREAM_HPP
 
+#include <mutex>
 #include <string>
 #include <cstdio>
 #include <cstdarg>
@@ -30,6 +31,10 @@
 namespace mitm {
 
 /** mitm::cstream is an inspired class from the std::ostream.
+ *
+ * The output is kept in a buffer written when it is full, at each line if
+ * the file descriptor is a terminal or the standard error, by flush() and
+ * by the destructor.
  *
  * @code
  * #include "cstream.hpp"
@@ -101,6 +106,9 @@ public:
     cstream& write(const std::string &str) noexcept;
     cstream& write(unsigned char c) noexcept;
 
+    /// Writes the buffer to the file descriptor.
+    cstream& flush() noexcept;
+
     cstream& set_modifier(modifier m) noexcept;
     cstream& reset_modifier() noexcept;
 
@@ -139,12 +147,52 @@ public:
     modifier reset() const noexcept { return { Default, Reset }; }
 
 private:
+    /// Writes the buffer, returns 0 or the errno of the failure. The
+    /// mutex must be locked.
+    int flush_buffer() noexcept;
+
+    /// Calls @e fn(first) to format at most @e size bytes at the end of
+    /// the buffer, @e fn returns the end of the text.
+    template <typename Function>
+    cstream& put(std::size_t size, Function fn) noexcept;
+
+    static const std::size_t capacity = 8192;
+
     /// \e fd the file descriptor.
     int fd;
 
     /// \e tty is true if the file descriptor allows colors (windows
     /// console or tty on unix).
     bool color_mode;
+
+    /// \e line_mode is true if the buffer is written at each line.
+    bool line_mode;
+
+    std::mutex mutex;
+    std::size_t used;
+    char buffer[capacity];
+};
+
+/** Flushes a cstream at the end of a scope. The solvers keep one on out()
+ * so that their log is written before they return to the caller.
+ */
+class flush_guard
+{
+public:
+    explicit flush_guard(cstream &stream) noexcept
+        : m_stream(stream)
+    {}
+
+    ~flush_guard() noexcept
+    {
+        m_stream.flush();
+    }
+
+    flush_guard(const flush_guard&) = delete;
+    flush_guard& operator=(const flush_guard&) = delete;
+
+private:
+    cstream &m_stream;
 };
 
 /** Give an access to the standard output stream (stdout).
@@ -168,7 +216,7 @@ cstream::write(const std::string &str) noexcept
 inline cstream&
 cstream::write(unsigned char c) noexcept
 {
-    return write(reinterpret_cast<char*>(c), 1);
+    return write(reinterpret_cast<const char*>(&c), 1);
 }
 
 }
@@ -21,255 +21,174 @@
  */
 
 #include <mitm/mitm.hpp>
-#include <iterator>
+#include <algorithm>
+#include <cstdint>
 #include <Eigen/Core>
 #include "cstream.hpp"
 #include "internal.hpp"
+#include "heuristic-classic.hpp"
+#include "thread-pool.hpp"
 #include "assert.hpp"
 
 namespace mitm {
 namespace classic {
 
-struct constraint
+/** best_solution keeps the best assignment seen by a heuristic: the one
+ * with the fewest violated constraints then the lowest cost.
+ */
+template <typename Real>
+struct best_solution
 {
-    std::vector<mitm::index> I;
-    std::vector<std::tuple<mitm::real, mitm::index>> r;
-    mitm::index k;
-    mitm::index n;
-    mitm::index bk;
-
-    constraint() = default;
-
-    constraint(mitm::index k_, mitm::index n_, mitm::index bk_,
-               const Eigen::MatrixXi& a)
-        : k(k_)
-        , bk(bk_)
+    bit_vector x;
+    Real value;
+    mitm::index violated;
+    mitm::index loop;
+
+    best_solution() = default;
+
+    template <typename Heuristic>
+    best_solution(const Heuristic& wh)
     {
-        for (mitm::index i = 0; i != n_; ++i) {
-            if (a(k, i) != 0) {
-                I.emplace_back(i);
-                r.emplace_back(0, i);
-            }
-        }
+        reset(wh);
     }
 
-    void update(const Eigen::MatrixXi& A, const Eigen::RowVectorXf& c,
-                Eigen::MatrixXf& P, Eigen::VectorXf& pi, Eigen::VectorXi& x,
-                mitm::real kappa, mitm::real l, mitm::real theta)
+    /// Start from the current assignment of @e wh, the bits already
+    /// allocated are reused.
+    template <typename Heuristic>
+    void reset(const Heuristic& wh)
     {
-        P.row(k) *= theta;
-
-        for (mitm::index i = 0; i != static_cast<mitm::index>(I.size()); ++i) {
-            mitm::real sum_a_hi_pi_h = 0;
-            mitm::real sum_a_hi_p_hi = 0;
-            for (mitm::index h = 0, endh = A.rows(); h != endh; ++h) {
-                if (A(h, i)) {
-                    sum_a_hi_pi_h += A(h, I[i]) * pi(h);
-                    sum_a_hi_p_hi += A(h, I[i]) * P(h, I[i]);
-                }
-            }
-
-            r[i] = std::make_tuple(c(I[i]) - sum_a_hi_pi_h - sum_a_hi_p_hi,
-                                   I[i]);
-        }
-
-        std::sort(r.begin(), r.end(),
-                  [](const std::tuple<mitm::real, mitm::index>& lhs,
-                     const std::tuple<mitm::real, mitm::index>& rhs)
-                  {
-                      return std::get<0>(lhs) < std::get<0>(rhs);
-                  });
-
-        pi(k) += (std::get<0>(r[bk - 1]) + std::get<0>(r[bk])) / 2.0;
-        const mitm::real delta = ((kappa / (1 - kappa)) *
-                                  (std::get<0>(r[bk - 1]) - std::get<0>(r[bk]))
-                             + l);
-
-        for (mitm::index j = 0; j < bk; ++j) {
-            x(std::get<1>(r[j])) = 1;
-            P(k, std::get<1>(r[j])) -= +delta;
-        }
-
-        for (mitm::index j = bk; j != static_cast<mitm::index>(I.size()); ++j) {
-            x(std::get<1>(r[j])) = 0;
-            P(k, std::get<1>(r[j])) -= -delta;
-        }
+        x = wh.x;
+        value = wh.objective;
+        violated = wh.activity.violated();
+        loop = 0;
     }
 
-    friend std::ostream&
-        operator<<(std::ostream& os, const constraint& c)
-        {
-            os << "k: " << c.k << " n: " << c.n << " bk: " << c.bk << '\n';
-            os << "I: ";
-            std::copy(c.I.cbegin(), c.I.cend(),
-                      std::ostream_iterator<mitm::index>(os, " "));
-
-            os << "\nr: ";
-            for (const auto& t : c.r)
-                os << '[' << std::get<0>(t) << ',' << std::get<1>(t) << "] ";
+    template <typename Heuristic>
+    void update(const Heuristic& wh, mitm::index loop_)
+    {
+        const mitm::index v = wh.activity.violated();
 
-            return os << '\n';
-        }
+        if (v < violated or (v == violated and wh.objective < value))
+            set(wh, loop_);
+    }
 
-    std::size_t size() const
+    /// Keep the current assignment of @e wh.
+    template <typename Heuristic>
+    void set(const Heuristic& wh, mitm::index loop_)
     {
-        return I.size() * sizeof(mitm::index) +
-            r.size() * sizeof(std::tuple<mitm::real, mitm::index>) +
-            3 * sizeof(mitm::index);
+        x = wh.x;
+        value = wh.objective;
+        violated = wh.activity.violated();
+        loop = loop_;
     }
 };
 
-struct wedelin_heuristic
+template <typename RowVector>
+mitm::result_summary
+make_summary(const bit_vector& x, const RowVector& c,
+             mitm::index loop, mitm::index violated, result_status status)
 {
-    std::size_t size() const
-    {
-        std::size_t ret = std::accumulate(
-            constraints.cbegin(),
-            constraints.cend(),
-            0.0, [](std::size_t init, const constraint& c)
-            {
-                return init + c.size();
-            });
-
-        ret += A.size() * sizeof(int) +
-            b.size() * sizeof(int) +
-            c.size() * sizeof(mitm::real) +
-            x.size() * sizeof(int) +
-            P.size() * sizeof(mitm::real) +
-            pi.size() * sizeof(mitm::real) +
-            2 * sizeof(index) +
-            3 * sizeof(mitm::real);
-
-        return ret;
-    }
-
-    std::vector <constraint> constraints;
-    Eigen::MatrixXi A;
-    Eigen::VectorXi b;
-    Eigen::RowVectorXf c;
-    Eigen::VectorXi x;
-    Eigen::MatrixXf P;
-    Eigen::VectorXf pi;
-    index m;
-    index n;
-    mitm::real kappa;
-    mitm::real l;
-    mitm::real theta;
-
-    wedelin_heuristic(const SimpleState &s, mitm::index m_, mitm::index n_,
-                      mitm::real k_, mitm::real l_, mitm::real theta_)
-        : constraints(m_)
-        , A(Eigen::MatrixXi::Zero(m_, n_))
-        , b(Eigen::VectorXi::Zero(m_))
-        , c(Eigen::RowVectorXf::Zero(n_))
-        , x(Eigen::VectorXi::Zero(n_))
-        , P(Eigen::MatrixXf::Zero(m_, n_))
-        , pi(Eigen::VectorXf::Zero(m_))
-        , m(m_)
-        , n(n_)
-        , kappa(k_)
-        , l(l_)
-        , theta(theta_)
-    {
-        {
-            mitm::index longi = 0;
-            for (mitm::index i = 0; i != m; ++i)
-                for (mitm::index j = 0; j != n; ++j, ++longi)
-                    A(i, j) = s.a[longi];
-        }
+    typename RowVector::Scalar value = 0;
 
-        for (mitm::index i = 0; i != m; ++i) {
-            b(i) = s.b[i];
-        }
+    x.for_each([&value, &c](mitm::index j) { value += c(j); });
 
-        for (mitm::index j = 0; j != n; ++j) {
-            c(j) = s.c[j];
-            x(j) = c(j) <= 0;
-        }
+    return { loop, static_cast<mitm::real>(value), violated, status };
+}
 
-        // TODO: intialize parameters delta, kappa.
-        Ensures(kappa >= 0 && kappa < 1, "kappa must be [0..1[");
-        Ensures(l >= 0, "l must be [0..+oo[");
-        Ensures(theta >= 0 && theta <= 1, "theta must be [0..1]");
+template <typename RowVector>
+mitm::result
+make_result(const bit_vector& x, const RowVector& c,
+            mitm::index loop, mitm::index violated, result_status status)
+{
+    mitm::result ret;
+    typename RowVector::Scalar value = 0;
 
-        constraints.clear();
-        for (mitm::index i = 0; i != m; ++i)
-            constraints.emplace_back(i, n, b(i), A);
-    }
+    ret.x.resize(x.length());
 
-    inline bool
-    is_constraint_need_update(mitm::index k) const
-    {
-        // TODO: Found a Eigen API (sum(A.row(k) * x(k)) == b(k).
-        int sum = 0;
-        for (mitm::index i = 0; i != n; ++i)
-            sum += A(k, i) * x(i);
+    x.for_each([&ret, &value, &c](mitm::index j)
+               {
+                   ret.x[j] = true;
+                   value += c(j);
+               });
 
-        return sum != b(k);
-    }
+    ret.value = static_cast<mitm::real>(value);
 
-    bool next()
-    {
-        for (mitm::index k = 0; k != m; ++k)
-            if (is_constraint_need_update(k))
-                constraints[k].update(A, c, P, pi, x, kappa, l, theta);
+    ret.loop = loop;
+    ret.violated = violated;
+    ret.status = status;
+    return ret;
+}
 
-        if (is_ax_equal_b())
-            return true;
+/** Run @e wh until a solution is found, @e o stops the run or @e stop()
+ * returns true. @e best keeps the solution or, without solution, the least
+ * violated assignment seen. The progress callback of @e o is used only if
+ * @e report is true.
+ */
+template <typename Heuristic, typename Stop>
+result_status
+search(Heuristic& wh, best_solution<typename Heuristic::real_type>& best,
+       const options &o, Stop stop, bool report = true)
+{
+    best.reset(wh);
+    result_status status = result_status::limit_reached;
 
-        // TODO: adjust parameters kappa, delta, theta
+    for (mitm::index it = 0; it != o.limit; ++it) {
+        if (is_interrupted(o, status) or stop())
+            break;
 
-        return false;
-    }
+        if (wh.next()) {
+            // O(nnz), the tests check the incremental activities.
+            assert(wh.activity.check(*wh.A, wh.b, wh.x));
 
-    friend std::ostream&
-        operator<<(std::ostream &os, const wedelin_heuristic &wh)
-        {
-            return os << "A:\n" << wh.A << '\n'
-                      << "P:\n" << wh.P << '\n'
-                      << "pi: " << wh.pi.transpose() << '\n'
-                      << "b: " << wh.b.transpose() << '\n'
-                      << "c: " << wh.c << '\n'
-                      << "X: " << wh.x.transpose() << '\n'
-                      << "(Ax): "<< (wh.A * wh.x).transpose() << '\n';
+            best.set(wh, it);
+            return result_status::success;
         }
 
-private:
-    bool is_ax_equal_b() const
-    {
-        return (A * x) == b;
+        best.update(wh, it);
+
+        if (report)
+            notify(o, it, wh.activity.violated(), wh.objective);
     }
-};
 
+    return status;
 }
 
+template <typename Heuristic, typename Stop>
 mitm::result
-heuristic_algorithm_default(const SimpleState &s, index limit,
-                            mitm::real kappa, mitm::real delta, mitm::real theta)
+solve(Heuristic& wh, const options &o, Stop stop, bool report = true)
 {
-    Expects(s.b.size() > 0 && s.c.size() > 0 &&
-            s.a.size() == s.b.size() * s.c.size(),
-            "heuristic_algorithm_default: state not initialized");
+    best_solution<typename Heuristic::real_type> best;
+    const result_status status = search(wh, best, o, stop, report);
+
+    return make_result(best.x, wh.c, best.loop, best.violated, status);
+}
 
-    mitm::classic::wedelin_heuristic wh(
-        s,
-        static_cast<mitm::index>(s.b.size()),
-        static_cast<mitm::index>(s.c.size()),
-        kappa, delta, theta);
+/** Show the parameters and the memory used by the heuristic @e wh then run
+ * it until a solution is found or @e o stops the run.
+ */
+template <typename Heuristic>
+mitm::result
+run(Heuristic& wh, const char *name, const options &o)
+{
+    const parameters &p = o.p;
 
-    mitm::out() << "heuristic_algorithm_default start:\n"
-                << "constraints: " << mitm::out().yellow() << s.b.size()
+    mitm::out() << name << " start:\n"
+                << "constraints: " << mitm::out().yellow() << wh.m
                 << mitm::out().reset()
-                << " variables: " << mitm::out().yellow() << s.c.size()
+                << " variables: " << mitm::out().yellow() << wh.n
                 << mitm::out().reset()
                 << "\nlimit: " << mitm::out().yellow()
-                << limit << mitm::out().reset()
+                << o.limit << mitm::out().reset()
                 << " kappa: " << mitm::out().yellow()
-                << kappa << mitm::out().reset()
+                << p.kappa << mitm::out().reset()
                 << " delta: " << mitm::out().yellow()
-                << delta << mitm::out().reset()
+                << p.delta << mitm::out().reset()
                 << " theta: " << mitm::out().yellow()
-                << theta << mitm::out().reset()
+                << p.theta << mitm::out().reset()
+                << " schedule: " << mitm::out().yellow()
+                << schedule_name(p.policy) << mitm::out().reset()
+                << " sweep: " << mitm::out().yellow()
+                << sweep_name(p.order) << mitm::out().reset()
                 << "\n"
                 << "Memory allocated: " << mitm::out().yellow();
 
@@ -281,22 +200,371 @@ heuristic_algorithm_default(const SimpleState &s, index limit,
         mitm::out() << (wh.size() / (1024.0 * 1024.0)) << " MB"
             << mitm::out().reset() << "\n";
 
-    for (mitm::index it = 0; it != limit; ++it) {
-        if (wh.next()) {
-            mitm::result ret;
+    return solve(wh, o, []() { return false; });
+}
+
+/// Throws if the dense model @e s is not initialized.
+inline void
+check(const SimpleState &s, const char *message)
+{
+    Expects(s.b.size() > 0 && s.c.size() > 0 &&
+            s.a.size() == s.b.size() * s.c.size(), message);
+}
 
-            ret.x.resize(wh.x.size());
+/// The views are checked by wedelin_heuristic::init().
+template <typename Index>
+inline void
+check(const basic_csr_view<Index>&, const char*) noexcept
+{}
 
-            for (mitm::index j = 0;
-                 j != static_cast<mitm::index>(s.c.size()); ++j)
-                ret.x[j] = wh.x(j);
+inline mitm::index
+constraints(const SimpleState &s) noexcept
+{
+    return s.constraints();
+}
+
+template <typename Index>
+inline mitm::index
+constraints(const basic_csr_view<Index> &model) noexcept
+{
+    return model.rows;
+}
+
+inline mitm::index
+variables(const SimpleState &s) noexcept
+{
+    return s.variables();
+}
+
+template <typename Index>
+inline mitm::index
+variables(const basic_csr_view<Index> &model) noexcept
+{
+    return model.cols;
+}
+
+}
+
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_default(const Model &s, const options &o)
+{
+    mitm::classic::check(
+        s, "heuristic_algorithm_default: state not initialized");
+
+    mitm::classic::wedelin_heuristic<Real, Index> wh(s, o.p);
+
+    return mitm::classic::run(wh, "heuristic_algorithm_default", o);
+}
 
-            ret.loop = it;
-            return ret;
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_parallel(const Model &s, const options &o)
+{
+    mitm::classic::check(
+        s, "heuristic_algorithm_parallel: state not initialized");
+
+    mitm::classic::parallel_wedelin_heuristic<Real, Index> wh(
+        s, o.p, std::thread::hardware_concurrency());
+
+    mitm::out() << "threads: " << mitm::out().yellow() << wh.pool.size()
+                << mitm::out().reset()
+                << " colors: " << mitm::out().yellow() << wh.colors.size()
+                << mitm::out().reset() << "\n";
+
+    return mitm::classic::run(wh, "heuristic_algorithm_parallel", o);
+}
+
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_portfolio(const Model &s, const options &o,
+                              const std::vector<parameters> &portfolio,
+                              unsigned thread_number, bool first_solution)
+{
+    mitm::classic::check(
+        s, "heuristic_algorithm_portfolio: state not initialized");
+    Expects(not portfolio.empty(),
+            "heuristic_algorithm_portfolio: empty portfolio");
+
+    const mitm::index size = static_cast<mitm::index>(portfolio.size());
+    thread_number = std::max(1u, std::min(thread_number,
+                                          static_cast<unsigned>(size)));
+
+    mitm::out() << "heuristic_algorithm_portfolio start:\n"
+                << "constraints: " << mitm::out().yellow()
+                << mitm::classic::constraints(s) << mitm::out().reset()
+                << " variables: " << mitm::out().yellow()
+                << mitm::classic::variables(s) << mitm::out().reset()
+                << "\nlimit: " << mitm::out().yellow()
+                << o.limit << mitm::out().reset()
+                << " parameters: " << mitm::out().yellow()
+                << size << mitm::out().reset()
+                << " threads: " << mitm::out().yellow()
+                << thread_number << mitm::out().reset() << "\n";
+
+    // Each instance writes only its own slot of the results, the
+    // cancellation flag stops the others after the first solution.
+    std::atomic<bool> cancel(false);
+    std::mutex mutex;
+    std::vector<mitm::result> results(size);
+    std::exception_ptr error;
+
+    // The first instance builds the matrix, the others share it and copy
+    // only the state of their sweeps. The solve never modifies A, b and c
+    // of the first one.
+    mitm::classic::wedelin_heuristic<Real, Index> first(s, portfolio[0]);
+
+    thread_pool pool(thread_number);
+    pool.parallel_for(
+        size,
+        [&](unsigned, mitm::index i)
+        {
+            try {
+                auto solve = [&](
+                    mitm::classic::wedelin_heuristic<Real, Index>& wh)
+                {
+                    return mitm::classic::solve(
+                        wh, o, [&cancel]()
+                        {
+                            return cancel.load(std::memory_order_relaxed);
+                        }, i == 0);
+                };
+
+                if (i == 0) {
+                    results[i] = solve(first);
+                } else {
+                    mitm::classic::wedelin_heuristic<Real, Index> wh(
+                        first, portfolio[i]);
+                    wh.shuffle(static_cast<unsigned>(i));
+                    results[i] = solve(wh);
+                }
+
+                if (first_solution and
+                    results[i].status == result_status::success)
+                    cancel = true;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+                cancel = true;
+            }
+        });
+
+    if (error)
+        std::rethrow_exception(error);
+
+    mitm::index best = 0;
+    for (mitm::index i = 1; i != size; ++i)
+        if (results[i].violated < results[best].violated or
+            (results[i].violated == results[best].violated and
+             results[i].value < results[best].value))
+            best = i;
+
+    mitm::out() << "best solution found with kappa: " << mitm::out().yellow()
+                << portfolio[best].kappa << mitm::out().reset()
+                << " delta: " << mitm::out().yellow()
+                << portfolio[best].delta << mitm::out().reset()
+                << " theta: " << mitm::out().yellow()
+                << portfolio[best].theta << mitm::out().reset() << "\n";
+
+    return results[best];
+}
+
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_portfolio(const Model &s, const options &o)
+{
+    const parameters &p = o.p;
+
+    // Parameter sets around the user's one: kappa, delta and theta are
+    // scaled by powers of two in turn.
+    const unsigned thread_number =
+        std::max(1u, std::thread::hardware_concurrency());
+    const unsigned size = std::max(4u, thread_number);
+
+    std::vector<parameters> portfolio;
+    for (unsigned i = 0; i != size; ++i) {
+        const mitm::real factor = static_cast<mitm::real>(1u << (i / 3 % 4));
+        parameters elem(p);
+
+        switch (i % 3) {
+        case 0:
+            elem.kappa = std::min(p.kappa * factor, mitm::real(0.99));
+            elem.kappa_max = std::max(elem.kappa, p.kappa_max);
+            break;
+        case 1:
+            elem.delta = p.delta * factor * 2;
+            break;
+        case 2:
+            elem.theta = std::min(p.theta * factor * 2, mitm::real(1));
+            break;
         }
+
+        portfolio.emplace_back(elem);
     }
 
-    throw std::runtime_error("no solution founded");
+    return heuristic_algorithm_portfolio<Real, Index>(s, o, portfolio,
+                                                      thread_number, true);
+}
+
+#define MITM_INSTANTIATE_CLASSIC(Real, Index, Model)                     \
+    template mitm::result                                                \
+    heuristic_algorithm_default<Real, Index, Model>(const Model&,        \
+                                                    const options&);     \
+    template mitm::result                                                \
+    heuristic_algorithm_parallel<Real, Index, Model>(const Model&,       \
+                                                     const options&);    \
+    template mitm::result                                                \
+    heuristic_algorithm_portfolio<Real, Index, Model>(const Model&,      \
+                                                      const options&);   \
+    template mitm::result                                                \
+    heuristic_algorithm_portfolio<Real, Index, Model>(                   \
+        const Model&, const options&,                                    \
+        const std::vector<parameters>&, unsigned, bool)
+
+MITM_INSTANTIATE_CLASSIC(float, std::int32_t, SimpleState);
+MITM_INSTANTIATE_CLASSIC(float, std::int64_t, SimpleState);
+MITM_INSTANTIATE_CLASSIC(double, std::int32_t, SimpleState);
+MITM_INSTANTIATE_CLASSIC(double, std::int64_t, SimpleState);
+MITM_INSTANTIATE_CLASSIC(real, std::int32_t, basic_csr_view<std::int32_t>);
+MITM_INSTANTIATE_CLASSIC(real, std::int64_t, basic_csr_view<std::int64_t>);
+
+#undef MITM_INSTANTIATE_CLASSIC
+
+struct solver::impl
+{
+    mitm::classic::wedelin_heuristic<real, std::int32_t> wh32;
+    mitm::classic::wedelin_heuristic<real, std::int64_t> wh64;
+    mitm::classic::best_solution<real> best;
+
+    template <typename Heuristic>
+    mitm::result solve(Heuristic& wh, const SimpleState &s,
+                       const options &o)
+    {
+        using index_type = typename Heuristic::index_type;
+
+        wh.init(s,
+                static_cast<index_type>(s.b.size()),
+                static_cast<index_type>(s.c.size()),
+                o.p);
+
+        const result_status status = search(o, wh);
+
+        return mitm::classic::make_result(best.x, wh.c, best.loop,
+                                          best.violated, status);
+    }
+
+    template <typename Heuristic>
+    result_status search(const options &o, Heuristic& wh)
+    {
+        Expects(o.progress_every > 0,
+                "solver::solve: progress_every must be [1..+oo[");
+
+        return mitm::classic::search(wh, best, o, []() { return false; });
+    }
+
+    template <typename Index>
+    mitm::classic::wedelin_heuristic<real, Index>& heuristic();
+};
+
+template <>
+mitm::classic::wedelin_heuristic<real, std::int32_t>&
+solver::impl::heuristic<std::int32_t>()
+{
+    return wh32;
+}
+
+template <>
+mitm::classic::wedelin_heuristic<real, std::int64_t>&
+solver::impl::heuristic<std::int64_t>()
+{
+    return wh64;
+}
+
+solver::solver()
+    : m_impl(new impl)
+{}
+
+solver::~solver() = default;
+
+solver::solver(solver&&) noexcept = default;
+
+solver& solver::operator=(solver&&) noexcept = default;
+
+mitm::result
+solver::solve(const SimpleState &s, const options &o)
+{
+    Expects(s.b.size() > 0 && s.c.size() > 0 &&
+            s.a.size() == s.b.size() * s.c.size(),
+            "solver::solve: state not initialized");
+
+    if (is_int32_addressable(s))
+        return m_impl->solve(m_impl->wh32, s, o);
+
+    return m_impl->solve(m_impl->wh64, s, o);
+}
+
+template <typename Index>
+mitm::result_summary
+solver::solve(const basic_csr_view<Index> &model, const options &o,
+              std::uint8_t *x)
+{
+    Expects(x, "solver::solve: null solution buffer");
+    Expects(is_ones(model), "solver::solve: coefficients must be 1");
+
+    auto& wh = m_impl->heuristic<Index>();
+    wh.init(model, o.p);
+
+    const result_status status = m_impl->search(o, wh);
+    const bit_vector& best = m_impl->best.x;
+
+    std::fill(x, x + model.cols, std::uint8_t(0));
+    best.for_each([x](mitm::index j) { x[j] = 1; });
+
+    return mitm::classic::make_summary(best, wh.c, m_impl->best.loop,
+                                       m_impl->best.violated, status);
+}
+
+template <typename Index>
+mitm::result_summary
+solver::solve(const basic_csr_view<Index> &model, const options &o,
+              std::vector<Index> &columns)
+{
+    Expects(is_ones(model), "solver::solve: coefficients must be 1");
+
+    auto& wh = m_impl->heuristic<Index>();
+    wh.init(model, o.p);
+
+    const result_status status = m_impl->search(o, wh);
+    const bit_vector& best = m_impl->best.x;
+
+    columns.clear();
+    best.for_each([&columns](mitm::index j)
+                  {
+                      columns.emplace_back(static_cast<Index>(j));
+                  });
+
+    return mitm::classic::make_summary(best, wh.c, m_impl->best.loop,
+                                       m_impl->best.violated, status);
+}
+
+template mitm::result_summary
+solver::solve<std::int32_t>(const basic_csr_view<std::int32_t>&,
+                            const options&, std::uint8_t*);
+template mitm::result_summary
+solver::solve<std::int64_t>(const basic_csr_view<std::int64_t>&,
+                            const options&, std::uint8_t*);
+template mitm::result_summary
+solver::solve<std::int32_t>(const basic_csr_view<std::int32_t>&,
+                            const options&, std::vector<std::int32_t>&);
+template mitm::result_summary
+solver::solve<std::int64_t>(const basic_csr_view<std::int64_t>&,
+                            const options&, std::vector<std::int64_t>&);
+
+std::size_t
+solver::size() const noexcept
+{
+    return m_impl->wh32.size() + m_impl->wh64.size() +
+        m_impl->best.x.size();
 }
 
 }
@@ -0,0 +1,908 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_HEURISTIC_CLASSIC_HPP
+#define FR_INRA_MITM_HEURISTIC_CLASSIC_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <ostream>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <Eigen/Core>
+#include "sparse-matrix.hpp"
+#include "penalty-matrix.hpp"
+#include "bit-vector.hpp"
+#include "bit-matrix.hpp"
+#include "kernels.hpp"
+#include "thread-pool.hpp"
+#include "schedule.hpp"
+#include "assert.hpp"
+
+namespace mitm {
+namespace classic {
+
+/** Set the @e size first elements of the Eigen vector @e v to zero. Eigen
+ * reallocates a vector at each change of size so the buffer only grows,
+ * the elements after @e size are unused.
+ */
+template <typename Vector>
+void
+fit(Vector& v, mitm::index size)
+{
+    if (v.size() < size)
+        v.resize(size);
+
+    v.head(size).setZero();
+}
+
+/** row_activity stores the activity (A x)_k of each constraint and the
+ * set of violated constraints. Both are updated when a variable changes
+ * so only the rows of the variable's column are visited.
+ *
+ * If A is a 0/1 matrix whose bit rows are smaller than its CSR arrays, the
+ * activities computed from scratch are AND + popcount over 64 bits words.
+ */
+template <typename Index>
+struct row_activity
+{
+    Eigen::VectorXi ax;
+    std::vector<Index> violated_rows;
+    std::vector<Index> where;
+    bit_matrix rows;
+
+    /// Compute the activities from scratch.
+    void init(const sparse_matrix<int, Index>& A, const Eigen::VectorXi& b,
+              const bit_vector& x)
+    {
+        // Without values, attach() gives the same ones to every row: the
+        // coefficients are only contiguous row by row.
+        bool binary = true;
+        for (Index k = 0; k != A.rows() and binary; ++k)
+            binary = std::all_of(A.row_values(k),
+                                 A.row_values(k) + A.row_length(k),
+                                 [](int value) { return value == 1; });
+
+        if (binary and bit_matrix::is_smaller(A))
+            rows.assign(A);
+        else
+            rows.clear();
+
+        fit(ax, A.rows());
+        violated_rows.clear();
+        where.assign(A.rows(), -1);
+
+        for (Index k = 0; k != A.rows(); ++k) {
+            ax(k) = compute(A, x, k);
+
+            if (ax(k) != b(k))
+                insert(k);
+        }
+    }
+
+    /// The activity of the row @e k computed from scratch.
+    int compute(const sparse_matrix<int, Index>& A, const bit_vector& x,
+                Index k) const
+    {
+        if (not rows.empty())
+            return rows.dot(k, x);
+
+        int ret = 0;
+        for (Index pos = A.row_begin(k), end = A.row_end(k);
+             pos != end; ++pos)
+            ret += A.value(pos) * x[A.column(pos)];
+
+        return ret;
+    }
+
+    /// Returns true if the incremental activities and violated rows are
+    /// the ones computed from scratch.
+    bool check(const sparse_matrix<int, Index>& A, const Eigen::VectorXi& b,
+               const bit_vector& x) const
+    {
+        for (Index k = 0; k != A.rows(); ++k)
+            if (ax(k) != compute(A, x, k) or
+                (ax(k) != b(k)) != (where[k] >= 0))
+                return false;
+
+        return true;
+    }
+
+    /// Add @e diff times the column @e j to the activities.
+    template <typename Function>
+    void shift(const sparse_matrix<int, Index>& A, const Eigen::VectorXi& b,
+               Index j, int diff, Function on_violated)
+    {
+        for (Index cpos = A.col_begin(j), end = A.col_end(j);
+             cpos != end; ++cpos) {
+            const Index h = A.row(cpos);
+            const bool was_violated = ax(h) != b(h);
+
+            ax(h) += A.value(A.position(cpos)) * diff;
+
+            const bool is_violated = ax(h) != b(h);
+            if (is_violated != was_violated) {
+                if (is_violated) {
+                    insert(h);
+                    on_violated(h);
+                } else {
+                    erase(h);
+                }
+            }
+        }
+    }
+
+    void shift(const sparse_matrix<int, Index>& A, const Eigen::VectorXi& b,
+               Index j, int diff)
+    {
+        shift(A, b, j, diff, [](Index) {});
+    }
+
+    bool is_violated(Index k, const Eigen::VectorXi& b) const
+    {
+        return ax(k) != b(k);
+    }
+
+    Index violated() const
+    {
+        return static_cast<Index>(violated_rows.size());
+    }
+
+    std::size_t size() const
+    {
+        return ax.size() * sizeof(int) +
+            (violated_rows.capacity() + where.size()) * sizeof(Index) +
+            rows.size();
+    }
+
+private:
+    void insert(Index k)
+    {
+        where[k] = static_cast<Index>(violated_rows.size());
+        violated_rows.emplace_back(k);
+    }
+
+    void erase(Index k)
+    {
+        const Index last = violated_rows.back();
+
+        violated_rows[where[k]] = last;
+        where[last] = where[k];
+        violated_rows.pop_back();
+        where[k] = -1;
+    }
+};
+
+/** constraint_arena packs the reduced costs buffers of all the constraints
+ * in contiguous arrays, in the order of the rows, so a sweep in index
+ * order streams through memory. The reduced costs of the row k start at
+ * the CSR position of its first coefficient, the variables of the
+ * constraint are read directly in the CSR arrays of A (structure of
+ * arrays). The rows with a selection (bk > 1 or general coefficients) also
+ * own a scratch buffer.
+ */
+template <typename Real>
+struct constraint_arena
+{
+    std::vector<Real> values;
+    std::vector<Real> scratch;
+
+    std::size_t size() const
+    {
+        return (values.size() + scratch.size()) * sizeof(Real);
+    }
+};
+
+template <typename Real, typename Index>
+struct constraint
+{
+    using row_vector = Eigen::Matrix<Real, 1, Eigen::Dynamic>;
+    using column_vector = Eigen::Matrix<Real, Eigen::Dynamic, 1>;
+
+    Index k;
+    Index bk;
+    Index offset;     ///< first element of the scratch buffer.
+    Index length;     ///< number of variables of the constraint.
+    bool set_partitioning;
+
+    constraint() = default;
+
+    constraint(Index k_, Index bk_, const sparse_matrix<int, Index>& a,
+               constraint_arena<Real>& arena)
+        : k(k_)
+        , bk(bk_)
+        , offset(0)
+        , length(a.row_length(k_))
+        , set_partitioning(bk_ == 1 and a.row_length(k_) >= 2)
+    {
+        for (Index pos = a.row_begin(k), end = a.row_end(k);
+             pos != end; ++pos)
+            if (a.value(pos) != 1)
+                set_partitioning = false;
+
+        // Set partitioning rows (0/1 coefficients and bk = 1) only need the
+        // minimum and second minimum reduced costs, other rows need a copy
+        // of the reduced costs for the selection.
+        if (not set_partitioning) {
+            offset = static_cast<Index>(arena.scratch.size());
+            arena.scratch.resize(offset + length);
+        }
+    }
+
+    /** Update the constraint @e k.
+     *
+     * @e u caches for each variable j the aggregate sum_h a_hj (pi_h + P_hj)
+     * and is adjusted in place when pi(k) and the row k of P change. The new
+     * values of the variables are given to @e assign(j, value).
+     *
+     * The @e bk variables with the smallest reduced costs are selected, on
+     * equal reduced costs the lowest positions in the row first.
+     */
+    template <typename Assign>
+    void update(const sparse_matrix<int, Index>& A,
+                constraint_arena<Real>& arena, const row_vector& c,
+                basic_penalty_matrix<Real, Index>& P, column_vector& pi,
+                row_vector& u, Assign& assign,
+                Real kappa, Real l, Real theta)
+    {
+        // An empty row violated by its b(k) can not be repaired.
+        if (length == 0)
+            return;
+
+        const basic_kernel_table<Real, Index>& kernel =
+            kernels<Real, Index>();
+        const Index begin = A.row_begin(k);
+        const Index *I = A.row_columns(k);
+        const int *a = A.row_values(k);
+        Real *values = arena.values.data() + begin;
+
+        kernel.reduced_costs(c.data(), u.data(), I, a, P.row_data(k),
+                             (theta - 1) * P.row_scale(k), values, length);
+        P.scale(k, theta);
+
+        const bool forced = not set_partitioning and
+            (bk <= 0 or bk >= length);
+        Real first, second;
+        Index position = -1;
+        Index ties = 0;
+
+        if (set_partitioning) {
+            const basic_min2<Real> bounds = kernel.select_min2(values,
+                                                               length);
+
+            first = bounds.first;
+            second = bounds.second;
+            position = bounds.position;
+        } else if (forced) {
+            // No variable or all the variables are selected: pi(k) moves to
+            // the smallest or the largest reduced cost.
+            first = bk <= 0 ? *std::min_element(values, values + length)
+                : *std::max_element(values, values + length);
+            second = first;
+            ties = bk <= 0 ? 0 : length - kernel.count_less(values, length,
+                                                            first);
+        } else {
+            Real *scratch = arena.scratch.data() + offset;
+
+            std::copy(values, values + length, scratch);
+            std::tie(first, second) = select_bk(scratch, scratch + length,
+                                                bk);
+            ties = bk - kernel.count_less(values, length, first);
+        }
+
+        // Without a gap between the selected and unselected variables, a
+        // forced row keeps them l apart.
+        const Real pi_change = (first + second) / 2.0;
+        const Real delta = forced ? -l : ((kappa / (1 - kappa)) *
+                                          (first - second)
+                                          + l);
+
+        pi(k) += pi_change;
+
+        // All the variables move as unselected ones, then the bk selected
+        // variables are corrected.
+        kernel.add_row(P.row_data(k), delta / P.row_scale(k), u.data(), I,
+                       a, pi_change + delta, length);
+
+        for (Index i = 0; i != length; ++i) {
+            bool selected;
+
+            if (set_partitioning) {
+                selected = i == position;
+            } else if (values[i] < first) {
+                selected = true;
+            } else if (values[i] == first and ties > 0) {
+                selected = true;
+                --ties;
+            } else {
+                selected = false;
+            }
+
+            assign(I[i], selected);
+
+            if (selected) {
+                P.add(k, begin + i, -2 * delta);
+                u(I[i]) -= a[i] * 2 * delta;
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return 4 * sizeof(Index) + sizeof(bool);
+    }
+};
+
+template <typename Real, typename Index>
+struct wedelin_heuristic
+{
+    using real_type = Real;
+    using index_type = Index;
+    using row_vector = Eigen::Matrix<Real, 1, Eigen::Dynamic>;
+    using column_vector = Eigen::Matrix<Real, Eigen::Dynamic, 1>;
+
+    std::size_t size() const
+    {
+        std::size_t ret = std::accumulate(
+            constraints.cbegin(),
+            constraints.cend(),
+            0.0, [](std::size_t init, const constraint<Real, Index>& c)
+            {
+                return init + c.size();
+            });
+
+        ret += arena.size() +
+            A->size() +
+            b.size() * sizeof(int) +
+            c.size() * sizeof(Real) +
+            x.size() +
+            P.size() +
+            (order.size() + rank.size()) * sizeof(Index) +
+            worklist.capacity() * sizeof(Index) +
+            stamp.size() * sizeof(unsigned long) +
+            pi.size() * sizeof(Real) +
+            u.size() * sizeof(Real) +
+            activity.size() +
+            2 * sizeof(Index) +
+            sizeof(parameters);
+
+        return ret;
+    }
+
+    constraint_arena<Real> arena;
+    std::vector <constraint<Real, Index>> constraints;
+    std::vector <Index> order;
+    std::vector <Index> rank;      ///< position of each constraint in order.
+    std::vector <Index> worklist;
+    std::vector <unsigned long> stamp;
+    unsigned long sweep_id;
+    unsigned long visited;  ///< constraints examined by all the loops.
+    std::shared_ptr<sparse_matrix<int, Index>> A; ///< shared by the copies.
+    Eigen::VectorXi b;
+    row_vector c;
+    bit_vector x;
+    basic_penalty_matrix<Real, Index> P;
+    column_vector pi;
+    row_vector u;
+    row_activity<Index> activity;
+    Real objective;
+    Index m;
+    Index n;
+    parameters p;
+
+    wedelin_heuristic() = default;
+
+    wedelin_heuristic(const SimpleState &s, const parameters &p_)
+    {
+        init(s,
+             static_cast<Index>(s.b.size()),
+             static_cast<Index>(s.c.size()),
+             p_);
+    }
+
+    wedelin_heuristic(const basic_csr_view<Index> &model,
+                      const parameters &p_)
+    {
+        init(model, p_);
+    }
+
+    /** Initialize the heuristic for the model of @e other with the
+     * parameters @e p_. The matrix A is shared with @e other, the state of
+     * the sweeps (P, x, pi, u...) is built. A portfolio keeps one matrix
+     * for all its instances.
+     */
+    wedelin_heuristic(const wedelin_heuristic &other, const parameters &p_)
+        : A(other.A)
+    {
+        setup(other.b.data(), other.c.data(), p_);
+    }
+
+    /** Initialize the heuristic for the model @e s. The buffers already
+     * allocated are reused: a model with as many or fewer constraints,
+     * variables and non zero coefficients than the previous one allocates
+     * nothing.
+     */
+    void init(const SimpleState &s, Index m_, Index n_, const parameters &p_)
+    {
+        own().assign(s.a, m_, n_);
+        setup(s.b.data(), s.c.data(), p_);
+    }
+
+    /** Initialize the heuristic for the model of the caller @e model. The
+     * CSR arrays of A are used in place, b and c are copied.
+     */
+    void init(const basic_csr_view<Index> &model, const parameters &p_)
+    {
+        Expects(model.rows > 0 && model.cols > 0 && model.rows_ptr &&
+                model.cols_index && model.b && model.c &&
+                model.rows_ptr[0] == 0,
+                "wedelin_heuristic: bad model view");
+
+        for (Index k = 0; k != model.rows; ++k) {
+            Expects(model.rows_ptr[k] <= model.rows_ptr[k + 1],
+                    "wedelin_heuristic: rows_ptr must be increasing");
+
+            for (Index pos = model.rows_ptr[k]; pos != model.rows_ptr[k + 1];
+                 ++pos)
+                Expects(model.cols_index[pos] >= 0 &&
+                        model.cols_index[pos] < model.cols,
+                        "wedelin_heuristic: column out of range");
+        }
+
+        own().attach(model.rows, model.cols, model.rows_ptr,
+                     model.cols_index, model.values);
+
+        // The rows of a column are increasing in the CSC index, a column
+        // repeated in a row appears as two equal consecutive rows.
+        for (Index j = 0; j != A->cols(); ++j)
+            for (Index cpos = A->col_begin(j) + 1, end = A->col_end(j);
+                 cpos < end; ++cpos)
+                Expects(A->row(cpos - 1) != A->row(cpos),
+                        "wedelin_heuristic: column repeated in a row");
+
+        setup(model.b, model.c, p_);
+    }
+
+private:
+    /// The matrix A to rebuild: the current one if no other instance
+    /// shares it, a new one otherwise.
+    sparse_matrix<int, Index>& own()
+    {
+        if (not A or A.use_count() != 1)
+            A = std::make_shared<sparse_matrix<int, Index>>();
+
+        return *A;
+    }
+
+    /// Initialize all but A from the right hand sides @e b_ and the costs
+    /// @e c_.
+    template <typename Cost>
+    void setup(const int *b_, const Cost *c_, const parameters &p_)
+    {
+        m = A->rows();
+        n = A->cols();
+        p = p_;
+        sweep_id = 0;
+        visited = 0;
+        order.resize(m);
+        rank.resize(m);
+        stamp.assign(m, 0);
+        worklist.clear();
+        fit(b, m);
+        fit(c, n);
+        x.assign(n);
+        P.assign(*A);
+        fit(pi, m);
+        fit(u, n);
+
+        for (Index i = 0; i != m; ++i) {
+            b(i) = b_[i];
+        }
+
+        for (Index j = 0; j != n; ++j) {
+            c(j) = c_[j];
+            x.set(j, c(j) <= 0);
+        }
+
+        activity.init(*A, b, x);
+        objective = value();
+
+        // TODO: intialize parameters delta, kappa.
+        Ensures(p.kappa >= 0 && p.kappa < 1, "kappa must be [0..1[");
+        Ensures(p.delta >= 0, "l must be [0..+oo[");
+        Ensures(p.theta >= 0 && p.theta <= 1, "theta must be [0..1]");
+        // A kappa above the default kappa_max is its own bound: only the
+        // schedules raise kappa.
+        p.kappa_max = std::max(p.kappa_max, p.kappa);
+        Ensures(p.kappa_max < 1, "kappa_max must be [kappa..1[");
+        Ensures(p.rate >= 0 && p.rate <= 1, "rate must be [0..1]");
+
+        arena.values.resize(A->nonzeros());
+        arena.scratch.clear();
+        constraints.clear();
+        constraints.reserve(m);
+        for (Index i = 0; i != m; ++i)
+            constraints.emplace_back(i, b(i), *A, arena);
+
+        std::iota(order.begin(), order.end(), 0);
+        std::iota(rank.begin(), rank.end(), 0);
+    }
+
+public:
+    /// Randomize the order of the constraints in the sweep, the worklist
+    /// of a loop follows the same order.
+    void shuffle(unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::shuffle(order.begin(), order.end(), gen);
+
+        for (Index i = 0; i != m; ++i)
+            rank[order[i]] = i;
+    }
+
+    Real value() const
+    {
+        Real ret = 0;
+        x.for_each([this, &ret](Index j) { ret += c(j); });
+
+        return ret;
+    }
+
+    /// Assign @e value to the variable @e j and update the activities and
+    /// the objective.
+    template <typename Function>
+    void assign(Index j, int value, Function on_violated)
+    {
+        const int diff = value - x[j];
+        if (diff == 0)
+            return;
+
+        objective += c(j) * diff;
+        x.set(j, value);
+        activity.shift(*A, b, j, diff, on_violated);
+    }
+
+    inline bool
+    is_constraint_need_update(Index k) const
+    {
+        return activity.is_violated(k, b);
+    }
+
+    bool next()
+    {
+        if (p.order == sweep::all) {
+            auto assign = [this](Index j, int value)
+                {
+                    this->assign(j, value, [](Index) {});
+                };
+
+            for (Index k : order)
+                if (is_constraint_need_update(k))
+                    constraints[k].update(*A, arena, c, P, pi, u, assign,
+                                          p.kappa, p.delta, p.theta);
+
+            visited += m;
+        } else {
+            next_worklist();
+        }
+
+        if (is_ax_equal_b())
+            return true;
+
+        adjust(p, activity.violated(), m);
+
+        return false;
+    }
+
+    /** Update only the violated constraints, in the order of the sweep, then
+     * the constraints which become violated during the loop. Each constraint
+     * is updated at most once per loop.
+     */
+    void next_worklist()
+    {
+        ++sweep_id;
+
+        worklist.assign(activity.violated_rows.cbegin(),
+                        activity.violated_rows.cend());
+
+        if (p.order == sweep::violation) {
+            std::sort(worklist.begin(), worklist.end(),
+                      [this](Index lhs, Index rhs)
+                      {
+                          const int l = std::abs(activity.ax(lhs) - b(lhs));
+                          const int r = std::abs(activity.ax(rhs) - b(rhs));
+
+                          return l > r or (l == r and
+                                           rank[lhs] < rank[rhs]);
+                      });
+        } else {
+            std::sort(worklist.begin(), worklist.end(),
+                      [this](Index lhs, Index rhs)
+                      {
+                          return rank[lhs] < rank[rhs];
+                      });
+        }
+
+        for (Index k : worklist)
+            stamp[k] = sweep_id;
+
+        auto push = [this](Index h)
+            {
+                if (stamp[h] != sweep_id) {
+                    stamp[h] = sweep_id;
+                    worklist.emplace_back(h);
+                }
+            };
+
+        auto assign = [this, &push](Index j, int value)
+            {
+                this->assign(j, value, push);
+            };
+
+        for (std::size_t i = 0; i != worklist.size(); ++i) {
+            const Index k = worklist[i];
+
+            if (is_constraint_need_update(k))
+                constraints[k].update(*A, arena, c, P, pi, u, assign,
+                                      p.kappa, p.delta, p.theta);
+        }
+
+        visited += worklist.size();
+    }
+
+    friend std::ostream&
+        operator<<(std::ostream &os, const wedelin_heuristic &wh)
+        {
+            return os << "A:\n" << *wh.A
+                      << "P:\n" << wh.P << '\n'
+                      << "pi: " << wh.pi.head(wh.m).transpose() << '\n'
+                      << "b: " << wh.b.head(wh.m).transpose() << '\n'
+                      << "c: " << wh.c.head(wh.n) << '\n'
+                      << "X: " << wh.x << '\n'
+                      << "(Ax): " << wh.activity.ax.head(wh.m).transpose()
+                      << '\n';
+        }
+
+protected:
+    bool is_ax_equal_b() const
+    {
+        return activity.violated() == 0;
+    }
+};
+
+/** Greedy coloring of the constraints conflict graph: two constraints with
+ * a common variable never have the same color.
+ *
+ * @return the list of constraints of each color.
+ */
+template <typename Index>
+std::vector<std::vector<Index>>
+color_constraints(const sparse_matrix<int, Index>& A)
+{
+    std::vector<Index> color(A.rows(), -1);
+    std::vector<Index> forbidden;
+    std::vector<std::vector<Index>> ret;
+
+    for (Index k = 0; k != A.rows(); ++k) {
+        for (Index pos = A.row_begin(k), end = A.row_end(k);
+             pos != end; ++pos) {
+            const Index j = A.column(pos);
+
+            for (Index cpos = A.col_begin(j), endh = A.col_end(j);
+                 cpos != endh; ++cpos)
+                if (color[A.row(cpos)] >= 0)
+                    forbidden[color[A.row(cpos)]] = k;
+        }
+
+        Index c = 0;
+        while (c != static_cast<Index>(forbidden.size()) and
+               forbidden[c] == k)
+            ++c;
+
+        if (c == static_cast<Index>(forbidden.size())) {
+            forbidden.emplace_back(-1);
+            ret.emplace_back();
+        }
+
+        color[k] = c;
+        ret[c].emplace_back(k);
+    }
+
+    return ret;
+}
+
+/** wedelin_heuristic with a parallel sweep.
+ *
+ * Constraints of a same color share no variable, they are updated
+ * concurrently on the thread pool. The activities are updated after each
+ * color so the result is the same as a sequential sweep of the constraints
+ * ordered by color, whatever the number of threads.
+ *
+ * With sweep::worklist, each color only visits its violated constraints
+ * and the ones which become violated during the loop, a constraint violated
+ * after its color is visited by a new pass over the colors. The order of
+ * the constraints of a color does not change their updates, so
+ * sweep::violation is the same as sweep::worklist.
+ */
+template <typename Real, typename Index>
+struct parallel_wedelin_heuristic : wedelin_heuristic<Real, Index>
+{
+    using base = wedelin_heuristic<Real, Index>;
+    using base::constraints;
+    using base::arena;
+    using base::A;
+    using base::b;
+    using base::c;
+    using base::x;
+    using base::P;
+    using base::pi;
+    using base::u;
+    using base::activity;
+    using base::objective;
+    using base::stamp;
+    using base::sweep_id;
+    using base::visited;
+    using base::m;
+    using base::p;
+
+    std::vector<std::vector<Index>> colors;
+    std::vector<Index> color_of;
+    std::vector<std::vector<Index>> pending;
+    std::vector<Index> batch;
+    std::vector<std::vector<std::tuple<Index, int>>> changes;
+    thread_pool pool;
+
+    template <typename Model>
+    parallel_wedelin_heuristic(const Model &model, const parameters &p_,
+                               unsigned thread_number)
+        : base(model, p_)
+        , colors(color_constraints(*A))
+        , color_of(m)
+        , pending(colors.size())
+        , changes(std::max(thread_number, 1u))
+        , pool(std::max(thread_number, 1u))
+    {
+        for (std::size_t i = 0; i != colors.size(); ++i)
+            for (Index k : colors[i])
+                color_of[k] = static_cast<Index>(i);
+    }
+
+    std::size_t size() const
+    {
+        std::size_t ret = base::size() + color_of.size() * sizeof(Index);
+
+        for (const auto& color : colors)
+            ret += color.size() * sizeof(Index);
+
+        return ret;
+    }
+
+    bool next()
+    {
+        if (p.order == sweep::all) {
+            for (const auto& color : colors)
+                update(color, [](Index) {});
+
+            visited += m;
+        } else {
+            next_worklist();
+        }
+
+        if (this->is_ax_equal_b())
+            return true;
+
+        adjust(p, activity.violated(), m);
+
+        return false;
+    }
+
+    /** Update the violated constraints of each color, then the constraints
+     * which become violated, until no constraint is left. Each constraint is
+     * updated at most once per loop.
+     */
+    void next_worklist()
+    {
+        ++sweep_id;
+
+        for (Index k : activity.violated_rows) {
+            stamp[k] = sweep_id;
+            pending[color_of[k]].emplace_back(k);
+        }
+
+        auto push = [this](Index h)
+            {
+                if (stamp[h] != sweep_id) {
+                    stamp[h] = sweep_id;
+                    pending[color_of[h]].emplace_back(h);
+                }
+            };
+
+        for (bool again = true; again;) {
+            again = false;
+
+            for (auto& list : pending) {
+                if (list.empty())
+                    continue;
+
+                // The changes are applied in the order of the workers, the
+                // sorted constraints make the loop independent of threads.
+                batch.swap(list);
+                std::sort(batch.begin(), batch.end());
+                update(batch, push);
+                visited += batch.size();
+                batch.clear();
+                again = true;
+            }
+        }
+    }
+
+    /// Update the violated constraints of @e rows, a color or a part of it,
+    /// @e on_violated(h) is called for each constraint h which becomes
+    /// violated.
+    template <typename Function>
+    void update(const std::vector<Index>& rows, Function on_violated)
+    {
+        pool.parallel_for(
+            static_cast<mitm::index>(rows.size()),
+            [this, &rows](unsigned worker, mitm::index i)
+            {
+                const Index k = rows[i];
+
+                if (not this->is_constraint_need_update(k))
+                    return;
+
+                // The bits of x are shared by the workers, the new values
+                // are written after the color.
+                auto& change = changes[worker];
+                auto assign = [this, &change](Index j, int value)
+                    {
+                        const int diff = value - x[j];
+                        if (diff != 0)
+                            change.emplace_back(j, diff);
+                    };
+
+                constraints[k].update(*A, arena, c, P, pi, u, assign,
+                                      p.kappa, p.delta, p.theta);
+            });
+
+        for (auto& change : changes) {
+            for (const auto& elem : change) {
+                x.set(std::get<0>(elem), std::get<1>(elem) > 0);
+                objective += c(std::get<0>(elem)) * std::get<1>(elem);
+                activity.shift(*A, b, std::get<0>(elem), std::get<1>(elem),
+                               on_violated);
+            }
+
+            change.clear();
+        }
+    }
+};
+
+}
+}
+
+#endif
@@ -92,14 +92,10 @@ gpgpu_properties_show()
 }
 
 result
-heuristic_algorithm_gpgu(const SimpleState &s, index limit,
-                         mitm::real kappa, mitm::real delta,
-			 mitm::real theta)
+heuristic_algorithm_gpgu(const SimpleState &s, const options &o)
 {
 (void)s;
-(void)limit;
-(void)kappa;
-(void)delta;
+(void)o;
   std::vector <int8> s_x(100, 0);
 
   std::cout << "Run in GPGPU\n";
@@ -118,7 +114,12 @@ heuristic_algorithm_gpgu(const SimpleState &s, index limit,
   cudaMemcpy(s_x.data(), x, s_x.size() * sizeof(int8_t), cudaMemcpyDeviceToHost);
   cudaFree(x);
 
-  return result();
+  result ret;
+  ret.loop = 0;
+  ret.value = 0;
+  ret.violated = static_cast<index>(s.b.size());
+  ret.status = result_status::limit_reached;
+  return ret;
 }
 
 }
@@ -23,25 +23,106 @@
 #ifndef FR_INRA_MITM_INTERNAL_HPP
 #define FR_INRA_MITM_INTERNAL_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <string>
 
 namespace mitm {
 
+/** Returns true and assigns @e status if the deadline of @e o is over or
+ * if its token is cancelled.
+ */
+inline bool
+is_interrupted(const options &o, result_status &status)
+{
+    if (o.token.is_cancelled()) {
+        status = result_status::cancelled;
+        return true;
+    }
+
+    if (o.deadline != options::clock::time_point::max() and
+        options::clock::now() >= o.deadline) {
+        status = result_status::time_limit;
+        return true;
+    }
+
+    return false;
+}
+
+/// Returns true if the std::int32_t positions address all the
+/// coefficients of the constraints matrix of @e s.
+inline bool
+is_int32_addressable(const SimpleState &s) noexcept
+{
+    return s.a.size() <= static_cast<std::size_t>(
+        std::numeric_limits<std::int32_t>::max());
+}
+
+/// Returns true if the std::int32_t positions address all the
+/// coefficients and the variables of @e view.
+inline bool
+is_int32_addressable(const csr_view &view) noexcept
+{
+    const index max = std::numeric_limits<std::int32_t>::max();
+
+    return view.rows_ptr and view.rows > 0 and view.rows < max and
+        view.cols > 0 and view.cols <= max and
+        view.rows_ptr[view.rows] >= 0 and view.rows_ptr[view.rows] <= max;
+}
+
+/// Returns true if all the coefficients of @e view are 1: the classic
+/// engines select b_k variables in a row, whatever their coefficients.
+template <typename Index>
+inline bool
+is_ones(const basic_csr_view<Index> &view) noexcept
+{
+    return not view.values or not view.rows_ptr or
+        std::all_of(view.values, view.values + view.rows_ptr[view.rows],
+                    [](int value) { return value == 1; });
+}
+
+/// Calls the progress callback of @e o if @e loop is a reporting loop.
+inline void
+notify(const options &o, index loop, index violated, real value)
+{
+    if (o.progress and (loop + 1) % o.progress_every == 0)
+        o.progress(loop, violated, value);
+}
+
+/** The classic engines with @e Real reduced costs and @e Index positions
+ * on a SimpleState or a basic_csr_view<Index> model, instantiated in
+ * heuristic-classic.cpp for float and double, std::int32_t and
+ * std::int64_t (real only for the views).
+ */
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_default(const Model &s, const options &o);
+
 mitm::result
-heuristic_algorithm_default(const SimpleState &s, index limit,
-                            mitm::real kappa, mitm::real delta,
-                            mitm::real theta);
+heuristic_algorithm_default(const NegativeCoefficient& s,
+                            const options &o);
 
+/// The heuristic for negative coefficients on a SparseState with bounds.
 mitm::result
-heuristic_algorithm_default(const NegativeCoefficient& s, index limit,
-                            mitm::real kappa, mitm::real delta,
-                            mitm::real theta);
+heuristic_algorithm_default(const SparseState& s, const options &o);
 
+template <typename Real, typename Index, typename Model>
 mitm::result
-heuristic_algorithm_gpgu(const SimpleState &s, index limit,
-                         mitm::real kappa, mitm::real delta,
-                         mitm::real theta);
+heuristic_algorithm_parallel(const Model &s, const options &o);
 
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_portfolio(const Model &s, const options &o);
+
+template <typename Real, typename Index, typename Model>
+mitm::result
+heuristic_algorithm_portfolio(const Model &s, const options &o,
+                              const std::vector<parameters> &portfolio,
+                              unsigned thread_number, bool first_solution);
+
+mitm::result
+heuristic_algorithm_gpgu(const SimpleState &s, const options &o);
 }
 
 #endif
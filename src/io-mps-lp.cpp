@@ -0,0 +1,1267 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mitm/mitm.hpp>
+#include "mapped-file.hpp"
+#include "text-chunks.hpp"
+#include "text-scanner.hpp"
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// A word of the mapped file, without copy.
+struct word
+{
+    const char *first;
+    const char *last;
+
+    bool is(const char *str) const noexcept
+    {
+        const char *ptr = first;
+        for (; ptr != last and *str; ++ptr, ++str)
+            if (*ptr != *str)
+                return false;
+
+        return ptr == last and *str == '\0';
+    }
+
+    /// As is() without case, for the keywords of the LP format. @e str is
+    /// lower case.
+    bool is_keyword(const char *str) const noexcept
+    {
+        const char *ptr = first;
+        for (; ptr != last and *str; ++ptr, ++str)
+            if ((*ptr >= 'A' and *ptr <= 'Z' ? *ptr - 'A' + 'a' : *ptr) !=
+                *str)
+                return false;
+
+        return ptr == last and *str == '\0';
+    }
+
+    bool operator==(const word &other) const noexcept
+    {
+        return last - first == other.last - other.first and
+            std::equal(first, last, other.first);
+    }
+};
+
+const double infinity = std::numeric_limits<double>::infinity();
+
+double
+to_real(const word &w, int line)
+{
+    mitm::text_scanner scanner(w.first, w.last, line);
+
+    return scanner.next_real<double>();
+}
+
+int
+to_coefficient(double value, int line)
+{
+    if (value != std::floor(value) or
+        std::abs(value) > std::numeric_limits<int>::max())
+        throw mitm::io_error("coefficient must be an integer", line);
+
+    return static_cast<int>(value);
+}
+
+/** The names of the rows or of the columns. The key buffer is reused
+ * between two lookups, only a new name allocates.
+ */
+class name_table
+{
+    std::unordered_map<std::string, mitm::index> m_names;
+    std::string m_key;
+
+public:
+    /// Returns the index of @e w or -1.
+    mitm::index find(const word &w)
+    {
+        m_key.assign(w.first, w.last);
+        auto it = m_names.find(m_key);
+
+        return it == m_names.end() ? -1 : it->second;
+    }
+
+    /// As find() with the key buffer @e key, for the concurrent readers.
+    mitm::index find(const word &w, std::string &key) const
+    {
+        key.assign(w.first, w.last);
+        auto it = m_names.find(key);
+
+        return it == m_names.end() ? -1 : it->second;
+    }
+
+    /// Returns the index of @e w, @e next if the name is new.
+    mitm::index insert(const word &w, mitm::index next)
+    {
+        m_key.assign(w.first, w.last);
+
+        return m_names.emplace(m_key, next).first->second;
+    }
+};
+
+/** Completes @e s read in compressed rows with the bounds @e lower and
+ * @e upper of the rows: the rows are the equalities of b if all are
+ * integer equalities without negative coefficient, otherwise the bounds
+ * are kept. The values are dropped if they are all 1.
+ */
+void
+finish(mitm::SparseState &s, const std::vector<double> &lower,
+       const std::vector<double> &upper, int line)
+{
+    const mitm::index m = static_cast<mitm::index>(lower.size());
+
+    if (m == 0)
+        throw mitm::io_error("no constraint", line);
+
+    if (s.c.empty())
+        throw mitm::io_error("no variable", line);
+
+    const bool ones = std::all_of(s.values.begin(), s.values.end(),
+                                  [](int value) { return value == 1; });
+    bool equalities = std::none_of(s.values.begin(), s.values.end(),
+                                   [](int value) { return value < 0; });
+
+    for (mitm::index k = 0; k != m and equalities; ++k)
+        equalities = lower[k] == upper[k] and
+            lower[k] == std::floor(lower[k]) and
+            std::abs(lower[k]) <= std::numeric_limits<int>::max();
+
+    s.b.assign(m, 0);
+    s.bounds.clear();
+
+    if (equalities) {
+        for (mitm::index k = 0; k != m; ++k)
+            s.b[k] = static_cast<int>(lower[k]);
+    } else {
+        s.bounds.resize(m);
+        for (mitm::index k = 0; k != m; ++k) {
+            s.bounds[k].lower_bound = static_cast<mitm::real>(lower[k]);
+            s.bounds[k].upper_bound = static_cast<mitm::real>(upper[k]);
+        }
+    }
+
+    if (ones)
+        s.values.clear();
+}
+
+/// The bound @e value of a variable, only the bounds of a binary variable
+/// are accepted.
+void
+check_bound(bool lower, double value, int line)
+{
+    if (value != (lower ? 0.0 : 1.0))
+        throw mitm::io_error("only binary variables are supported", line);
+}
+
+/** line_reader splits the mapped file in lines and the lines in words
+ * separated by spaces. The empty lines and the lines starting with '*'
+ * are skipped. The lines are counted from 0.
+ */
+class line_reader
+{
+    const char *m_first;
+    const char *m_last;
+    const char *m_ptr;
+    const char *m_end;
+    int m_line;
+
+public:
+    line_reader(const char *first, const char *last) noexcept
+        : m_first(first)
+        , m_last(last)
+        , m_ptr(first)
+        , m_end(first)
+        , m_line(-1)
+    {}
+
+    int line() const noexcept
+    {
+        return m_line;
+    }
+
+    [[noreturn]] void error(const char *message) const
+    {
+        throw mitm::io_error(message, m_line);
+    }
+
+    /// The text after the current line.
+    const char *rest() const noexcept
+    {
+        return m_first;
+    }
+
+    /// Moves before @e first, the start of the line @e line.
+    void seek(const char *first, int line) noexcept
+    {
+        m_first = first;
+        m_ptr = first;
+        m_end = first;
+        m_line = line - 1;
+    }
+
+    /// Moves to the next line with a word, returns false at the end.
+    bool next() noexcept
+    {
+        while (m_first != m_last) {
+            m_ptr = m_first;
+            m_end = std::find(m_first, m_last, '\n');
+            m_first = m_end == m_last ? m_last : m_end + 1;
+            ++m_line;
+
+            if (*m_ptr == '*')
+                continue;
+
+            word w;
+            const char *start = m_ptr;
+            if (next_word(w)) {
+                m_ptr = start;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// A section starts at the first column, the data lines with a space.
+    bool is_section() const noexcept
+    {
+        return *m_ptr != ' ' and *m_ptr != '\t';
+    }
+
+    /// Reads the next word of the line, returns false at the end.
+    bool next_word(word &w) noexcept
+    {
+        while (m_ptr != m_end and (*m_ptr == ' ' or *m_ptr == '\t' or
+                                   *m_ptr == '\r'))
+            ++m_ptr;
+
+        if (m_ptr == m_end)
+            return false;
+
+        w.first = m_ptr;
+        while (m_ptr != m_end and *m_ptr != ' ' and *m_ptr != '\t' and
+               *m_ptr != '\r')
+            ++m_ptr;
+        w.last = m_ptr;
+
+        return true;
+    }
+
+    /// Reads the words of the line in @e words, returns their number.
+    int split(word *words, int size) noexcept
+    {
+        int ret = 0;
+        word w;
+
+        while (next_word(w)) {
+            if (ret == size)
+                return size + 1;
+
+            words[ret++] = w;
+        }
+
+        return ret;
+    }
+};
+
+/** Returns the end of the data lines starting at @e first: the start of
+ * the next section line or @e last. @e lines is the number of lines
+ * started before the end.
+ */
+const char*
+section_end(const char *first, const char *last, int &lines) noexcept
+{
+    lines = 0;
+
+    while (first != last) {
+        const char *end = std::find(first, last, '\n');
+
+        if (*first != ' ' and *first != '\t' and *first != '*' and
+            std::find_if(first, end, [](char c)
+                         {
+                             return c != ' ' and c != '\t' and c != '\r';
+                         }) != end)
+            return first;
+
+        ++lines;
+        first = end == last ? last : end + 1;
+    }
+
+    return last;
+}
+
+/** The lines of a chunk of the COLUMNS section, read without the columns
+ * of the previous chunks: the runs of lines of a same column and their
+ * non-zero coefficients. The lines are counted from the chunk start and
+ * the reading stops at the first error.
+ */
+struct column_chunk
+{
+    struct run
+    {
+        word name;
+        int line;
+        std::size_t first;      ///< its first coefficient.
+        bool has_cost;
+        double cost;
+    };
+
+    column_chunk()
+        : error_line(-1)
+    {}
+
+    std::vector<run> runs;
+    std::vector<mitm::index> rows;
+    std::vector<int> coefficients;
+    std::vector<int> lines;
+    std::string error;
+    int error_line;
+    std::exception_ptr failure;
+};
+
+void
+read_column_chunk(const char *first, const char *last,
+                  const name_table &row_names, mitm::index objective,
+                  column_chunk &c)
+{
+    line_reader lines(first, last);
+    std::string key;
+    word words[6];
+
+    try {
+        while (lines.next()) {
+            const int size = lines.split(words, 5);
+
+            if (size == 3 and words[1].is("'MARKER'"))
+                continue;
+
+            if (size != 3 and size != 5)
+                lines.error("column, row and value expected");
+
+            if (c.runs.empty() or not (c.runs.back().name == words[0]))
+                c.runs.push_back({ words[0], lines.line(), c.rows.size(),
+                                   false, 0.0 });
+
+            column_chunk::run &run = c.runs.back();
+
+            for (int i = 1; i < size; i += 2) {
+                const mitm::index k = row_names.find(words[i], key);
+                if (k == -1)
+                    lines.error("unknown row");
+
+                const double value = to_real(words[i + 1], lines.line());
+
+                if (k == objective) {
+                    run.has_cost = true;
+                    run.cost = value;
+                } else if (k >= 0 and value != 0) {
+                    // The coefficient is kept before its check: the
+                    // repetition is reported first as in a sequential
+                    // reading.
+                    c.rows.push_back(k);
+                    c.lines.push_back(lines.line());
+                    c.coefficients.push_back(0);
+                    c.coefficients.back() = to_coefficient(value,
+                                                           lines.line());
+                }
+            }
+        }
+    } catch (const mitm::io_error &e) {
+        c.error = e.message();
+        c.error_line = e.line();
+    } catch (...) {
+        c.failure = std::current_exception();
+    }
+}
+
+/** The MPS reader: the rows are declared before the columns, the columns
+ * are read in compressed columns then turned in compressed rows by a
+ * counting sort. The COLUMNS section is read by chunks in parallel with
+ * @e policy and merged in order.
+ */
+void
+read_mps(const char *first, const char *last, mitm::SparseState &s,
+         const mitm::chunk_policy &policy)
+{
+    enum class section
+    {
+        none, name, objsense, rows, columns, rhs, ranges, bounds, end
+    };
+
+    // The rows of type N are stored as -2 for the objective, -3, -4...
+    // for the free rows ignored.
+    const mitm::index objective = -2;
+    mitm::index next_free_row = -2;
+
+    line_reader lines(first, last);
+    section current = section::none;
+    name_table row_names, column_names;
+    std::vector<char> types;
+    std::vector<double> rhs, ranges;
+    std::vector<mitm::index> cols_ptr(1, 0);
+    std::vector<mitm::index> rows_index;
+    std::vector<int> coefficients;
+    std::vector<mitm::index> stamp;
+    word words[6];
+    word name = { nullptr, nullptr };
+    mitm::index rows = 0;
+    double sense = 1;
+
+    s.rows_ptr.clear();
+    s.cols_index.clear();
+    s.values.clear();
+    s.c.clear();
+
+    auto row = [&](const word &w) -> mitm::index
+        {
+            const mitm::index k = row_names.find(w);
+            if (k == -1)
+                lines.error("unknown row");
+
+            return k;
+        };
+
+    auto column = [&](const word &w) -> mitm::index
+        {
+            const mitm::index j = column_names.find(w);
+            if (j == -1)
+                lines.error("unknown column");
+
+            return j;
+        };
+
+    auto read_columns = [&]()
+        {
+            int count = 0;
+            const int line = lines.line() + 1;
+            const char *begin = lines.rest();
+            const char *end = ::section_end(begin, last, count);
+            const auto ranges = mitm::split_lines(begin, end, policy);
+            std::vector<column_chunk> chunks(ranges.size());
+
+            {
+                mitm::thread_pool pool(std::min(
+                    policy.threads, static_cast<unsigned>(ranges.size())));
+
+                pool.parallel_for(
+                    static_cast<mitm::index>(ranges.size()),
+                    [&](unsigned, mitm::index k)
+                    {
+                        ::read_column_chunk(ranges[k].first,
+                                            ranges[k].second, row_names,
+                                            objective, chunks[k]);
+                    });
+            }
+
+            stamp.resize(types.size(), -1);
+            int offset = line;
+
+            for (std::size_t k = 0; k != chunks.size(); ++k) {
+                const column_chunk &c = chunks[k];
+
+                for (std::size_t r = 0; r != c.runs.size(); ++r) {
+                    const column_chunk::run &run = c.runs[r];
+
+                    if (s.c.empty() or not (name == run.name)) {
+                        const mitm::index j =
+                            static_cast<mitm::index>(s.c.size());
+                        if (column_names.insert(run.name, j) != j)
+                            throw mitm::io_error("column not contiguous",
+                                                 offset + run.line);
+
+                        if (j > 0)
+                            cols_ptr.push_back(
+                                static_cast<mitm::index>(rows_index.size()));
+
+                        s.c.push_back(0);
+                        name = run.name;
+                    }
+
+                    const mitm::index j =
+                        static_cast<mitm::index>(s.c.size()) - 1;
+                    const std::size_t stop = r + 1 == c.runs.size() ?
+                        c.rows.size() : c.runs[r + 1].first;
+
+                    if (run.has_cost)
+                        s.c[j] = static_cast<mitm::real>(sense * run.cost);
+
+                    for (std::size_t e = run.first; e != stop; ++e) {
+                        const mitm::index row = c.rows[e];
+
+                        if (stamp[row] == j)
+                            throw mitm::io_error("coefficient repeated",
+                                                 offset + c.lines[e]);
+
+                        stamp[row] = j;
+                        rows_index.push_back(row);
+                        coefficients.push_back(c.coefficients[e]);
+                    }
+                }
+
+                if (c.failure)
+                    std::rethrow_exception(c.failure);
+
+                if (c.error_line >= 0)
+                    throw mitm::io_error(c.error.c_str(),
+                                         offset + c.error_line);
+
+                offset += static_cast<int>(std::count(
+                    ranges[k].first, ranges[k].second, '\n'));
+            }
+
+            lines.seek(end, line + count);
+        };
+
+    while (current != section::end and lines.next()) {
+        if (lines.is_section()) {
+            const int size = lines.split(words, 2);
+
+            if (words[0].is("NAME"))
+                current = section::name;
+            else if (words[0].is("OBJSENSE"))
+                current = section::objsense;
+            else if (words[0].is("ROWS"))
+                current = section::rows;
+            else if (words[0].is("COLUMNS"))
+                current = section::columns;
+            else if (words[0].is("RHS"))
+                current = section::rhs;
+            else if (words[0].is("RANGES"))
+                current = section::ranges;
+            else if (words[0].is("BOUNDS"))
+                current = section::bounds;
+            else if (words[0].is("ENDATA"))
+                current = section::end;
+            else
+                lines.error("unknown section");
+
+            if (current == section::objsense and size == 2)
+                sense = words[1].is("MAX") or words[1].is("MAXIMIZE") ?
+                    -1 : 1;
+
+            if (current == section::columns)
+                read_columns();
+
+            continue;
+        }
+
+        const int size = lines.split(words, 5);
+
+        switch (current) {
+        case section::none:
+            lines.error("section expected");
+
+        case section::name:
+        case section::columns:
+        case section::end:
+            break;
+
+        case section::objsense:
+            sense = words[0].is("MAX") or words[0].is("MAXIMIZE") ? -1 : 1;
+            break;
+
+        case section::rows:
+            if (size != 2 or words[0].last - words[0].first != 1)
+                lines.error("row type and name expected");
+
+            switch (*words[0].first) {
+            case 'N':
+                if (row_names.insert(words[1], next_free_row) !=
+                    next_free_row)
+                    lines.error("row repeated");
+
+                --next_free_row;
+                break;
+            case 'E':
+            case 'L':
+            case 'G':
+                if (row_names.insert(words[1], rows) != rows)
+                    lines.error("row repeated");
+
+                types.push_back(*words[0].first);
+                ++rows;
+                break;
+            default:
+                lines.error("unknown row type");
+            }
+            break;
+
+        case section::rhs:
+        case section::ranges: {
+            // The name of the vector is optional.
+            const int start = size % 2;
+
+            if (size < 2 or size > 5)
+                lines.error("row and value expected");
+
+            std::vector<double> &values =
+                current == section::rhs ? rhs : ranges;
+            values.resize(types.size(),
+                          current == section::rhs ? 0 : infinity);
+
+            for (int i = start; i < size; i += 2) {
+                const mitm::index k = row(words[i]);
+                if (k >= 0)
+                    values[k] = to_real(words[i + 1], lines.line());
+            }
+            break;
+        }
+
+        case section::bounds: {
+            if (size < 2 or size > 4 or
+                words[0].last - words[0].first != 2)
+                lines.error("bound type and column expected");
+
+            const word &type = words[0];
+            const bool has_value = not (type.is("BV") or type.is("FR") or
+                                        type.is("MI") or type.is("PL"));
+            const int col = (has_value ? size == 4 : size >= 3) ? 2 : 1;
+            column(words[col]);
+
+            if (type.is("UP") or type.is("UI") or type.is("LO") or
+                type.is("LI")) {
+                if (col + 1 >= size)
+                    lines.error("bound value expected");
+
+                check_bound(type.is("LO") or type.is("LI"),
+                            to_real(words[col + 1], lines.line()),
+                            lines.line());
+            } else if (not type.is("BV")) {
+                lines.error("only binary variables are supported");
+            }
+            break;
+        }
+        }
+    }
+
+    // The compressed columns in compressed rows, the columns of a row are
+    // increasing.
+    const mitm::index m = static_cast<mitm::index>(types.size());
+    const mitm::index n = static_cast<mitm::index>(s.c.size());
+
+    if (n > 0)
+        cols_ptr.push_back(static_cast<mitm::index>(rows_index.size()));
+
+    s.rows_ptr.assign(m + 1, 0);
+    for (mitm::index k : rows_index)
+        ++s.rows_ptr[k + 1];
+
+    for (mitm::index k = 0; k != m; ++k)
+        s.rows_ptr[k + 1] += s.rows_ptr[k];
+
+    std::vector<mitm::index> cursor(s.rows_ptr.begin(), s.rows_ptr.end() - 1);
+    s.cols_index.resize(rows_index.size());
+    s.values.resize(rows_index.size());
+
+    for (mitm::index j = 0; j != n; ++j) {
+        for (mitm::index pos = cols_ptr[j]; pos != cols_ptr[j + 1]; ++pos) {
+            const mitm::index target = cursor[rows_index[pos]]++;
+            s.cols_index[target] = j;
+            s.values[target] = coefficients[pos];
+        }
+    }
+
+    rhs.resize(m, 0);
+    ranges.resize(m, infinity);
+    std::vector<double> lower(m), upper(m);
+
+    for (mitm::index k = 0; k != m; ++k) {
+        const double range = std::abs(ranges[k]);
+
+        switch (types[k]) {
+        case 'E':
+            lower[k] = ranges[k] < 0 ? rhs[k] - range : rhs[k];
+            upper[k] = ranges[k] > 0 and range != infinity ?
+                rhs[k] + range : rhs[k];
+            break;
+        case 'L':
+            lower[k] = rhs[k] - range;
+            upper[k] = rhs[k];
+            break;
+        default:
+            lower[k] = rhs[k];
+            upper[k] = rhs[k] + range;
+            break;
+        }
+    }
+
+    finish(s, lower, upper, lines.line());
+}
+
+/** lp_lexer splits a CPLEX LP file in names, numbers and operators. A
+ * backslash starts a comment until the end of the line. The lines are
+ * counted from 0.
+ */
+class lp_lexer
+{
+public:
+    enum class kind
+    {
+        name, number, less, greater, equal, plus, minus, colon, end
+    };
+
+    struct token
+    {
+        kind type;
+        word w;
+        double value;
+        int line;
+    };
+
+private:
+    const char *m_first;
+    const char *m_last;
+    int m_line;
+    token m_current;
+
+    /// Skips the spaces and the comments, returns false at the end.
+    bool skip() noexcept
+    {
+        while (m_first != m_last) {
+            switch (*m_first) {
+            case '\\':
+                while (m_first != m_last and *m_first != '\n')
+                    ++m_first;
+                break;
+            case '\n':
+                ++m_line;
+                ++m_first;
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+                ++m_first;
+                break;
+            default:
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool is_digit(char c) noexcept
+    {
+        return static_cast<unsigned>(c - '0') < 10u;
+    }
+
+    static bool is_name(char c) noexcept
+    {
+        switch (c) {
+        case ' ': case '\t': case '\r': case '\n': case '\\':
+        case '<': case '>': case '=': case ':': case '+': case '-':
+            return false;
+        default:
+            return true;
+        }
+    }
+
+public:
+    lp_lexer(const char *first, const char *last)
+        : m_first(first)
+        , m_last(last)
+        , m_line(0)
+    {
+        advance();
+    }
+
+    const token& current() const noexcept
+    {
+        return m_current;
+    }
+
+    [[noreturn]] void error(const char *message) const
+    {
+        throw mitm::io_error(message, m_current.line);
+    }
+
+    /// Returns true if the token after the current one is a colon.
+    bool colon_follows() const noexcept
+    {
+        const char *ptr = m_first;
+        while (ptr != m_last and (*ptr == ' ' or *ptr == '\t' or
+                                  *ptr == '\r' or *ptr == '\n'))
+            ++ptr;
+
+        return ptr != m_last and *ptr == ':';
+    }
+
+    void advance()
+    {
+        if (not skip()) {
+            m_current.type = kind::end;
+            m_current.line = m_line;
+            return;
+        }
+
+        m_current.line = m_line;
+        m_current.w.first = m_first;
+
+        switch (*m_first) {
+        case '<':
+        case '>':
+            m_current.type = *m_first == '<' ? kind::less : kind::greater;
+            if (++m_first != m_last and *m_first == '=')
+                ++m_first;
+            break;
+        case '=':
+            m_current.type = kind::equal;
+            if (++m_first != m_last and (*m_first == '<' or *m_first == '>'))
+                m_current.type = *m_first++ == '<' ? kind::less
+                    : kind::greater;
+            break;
+        case ':':
+            m_current.type = kind::colon;
+            ++m_first;
+            break;
+        case '+':
+            m_current.type = kind::plus;
+            ++m_first;
+            break;
+        case '-':
+            m_current.type = kind::minus;
+            ++m_first;
+            break;
+        default:
+            if (is_digit(*m_first) or *m_first == '.') {
+                while (m_first != m_last and
+                       (is_digit(*m_first) or *m_first == '.'))
+                    ++m_first;
+
+                // An exponent only if digits follow, 2e is 2 times e.
+                if (m_first != m_last and (*m_first == 'e' or
+                                           *m_first == 'E')) {
+                    const char *ptr = m_first + 1;
+                    if (ptr != m_last and (*ptr == '+' or *ptr == '-'))
+                        ++ptr;
+                    if (ptr != m_last and is_digit(*ptr)) {
+                        while (ptr != m_last and is_digit(*ptr))
+                            ++ptr;
+                        m_first = ptr;
+                    }
+                }
+
+                m_current.type = kind::number;
+                m_current.w.last = m_first;
+                m_current.value = to_real(m_current.w, m_line);
+                return;
+            }
+
+            m_current.type = kind::name;
+            while (m_first != m_last and is_name(*m_first))
+                ++m_first;
+            break;
+        }
+
+        m_current.w.last = m_first;
+    }
+};
+
+/** The LP reader: the rows are read in order and stored directly in
+ * compressed rows, the columns are numbered at their first use.
+ */
+class lp_reader
+{
+    enum class section
+    {
+        none, objective, constraints, bounds, binary, end
+    };
+
+    using kind = lp_lexer::kind;
+
+    lp_lexer m_lexer;
+    mitm::SparseState &m_state;
+    name_table m_columns;
+    std::vector<std::pair<mitm::index, double>> m_terms;
+    std::vector<double> m_lower;
+    std::vector<double> m_upper;
+    double m_sense;
+
+    bool is(kind type) const noexcept
+    {
+        return m_lexer.current().type == type;
+    }
+
+    bool is_comparison() const noexcept
+    {
+        return is(kind::less) or is(kind::greater) or is(kind::equal);
+    }
+
+    /// Returns the section of the keyword of the current token or
+    /// section::none, @e sense is -1 for a maximization.
+    section keyword(double &sense) const
+    {
+        if (not is(kind::name))
+            return section::none;
+
+        const word &w = m_lexer.current().w;
+        sense = 1;
+
+        if (w.is_keyword("minimize") or w.is_keyword("minimum") or
+            w.is_keyword("min"))
+            return section::objective;
+
+        if (w.is_keyword("maximize") or w.is_keyword("maximum") or
+            w.is_keyword("max")) {
+            sense = -1;
+            return section::objective;
+        }
+
+        if (w.is_keyword("subject") or w.is_keyword("such") or
+            w.is_keyword("st") or w.is_keyword("s.t."))
+            return section::constraints;
+
+        if (w.is_keyword("bounds") or w.is_keyword("bound"))
+            return section::bounds;
+
+        if (w.is_keyword("binary") or w.is_keyword("binaries") or
+            w.is_keyword("bin"))
+            return section::binary;
+
+        if (w.is_keyword("general") or w.is_keyword("generals") or
+            w.is_keyword("gen") or w.is_keyword("semi-continuous") or
+            w.is_keyword("semis") or w.is_keyword("semi"))
+            m_lexer.error("only binary variables are supported");
+
+        if (w.is_keyword("end"))
+            return section::end;
+
+        return section::none;
+    }
+
+    bool is_keyword() const
+    {
+        double sense;
+
+        return keyword(sense) != section::none;
+    }
+
+    /// Returns the column of the current name, a new column has no cost.
+    mitm::index column()
+    {
+        const mitm::index j = m_columns.insert(
+            m_lexer.current().w, static_cast<mitm::index>(m_state.c.size()));
+
+        if (j == static_cast<mitm::index>(m_state.c.size()))
+            m_state.c.push_back(0);
+
+        m_lexer.advance();
+
+        return j;
+    }
+
+    /// Reads an optional sign and a number or an infinity.
+    double value()
+    {
+        double sign = 1;
+        for (; is(kind::plus) or is(kind::minus); m_lexer.advance())
+            if (is(kind::minus))
+                sign = -sign;
+
+        double ret;
+        if (is(kind::number))
+            ret = m_lexer.current().value;
+        else if (is(kind::name) and (m_lexer.current().w.is_keyword("inf") or
+                                     m_lexer.current().w.is_keyword(
+                                         "infinity")))
+            ret = infinity;
+        else
+            m_lexer.error("number expected");
+
+        m_lexer.advance();
+
+        return sign * ret;
+    }
+
+    /** Reads the terms of a linear expression in m_terms until a
+     * comparison, a keyword or the end. Returns the sum of the constants.
+     */
+    double expression()
+    {
+        double constant = 0;
+
+        m_terms.clear();
+
+        for (;;) {
+            double sign = 1;
+            bool has_sign = false;
+
+            for (; is(kind::plus) or is(kind::minus); m_lexer.advance()) {
+                if (is(kind::minus))
+                    sign = -sign;
+                has_sign = true;
+            }
+
+            if (is(kind::number)) {
+                const double coefficient = sign * m_lexer.current().value;
+                m_lexer.advance();
+
+                if (is(kind::name) and not is_keyword())
+                    m_terms.emplace_back(column(), coefficient);
+                else
+                    constant += coefficient;
+            } else if (is(kind::name) and (has_sign or not is_keyword())) {
+                m_terms.emplace_back(column(), sign);
+            } else {
+                if (has_sign)
+                    m_lexer.error("term expected");
+
+                return constant;
+            }
+        }
+    }
+
+    /// Reads an optional `name:' label.
+    void label()
+    {
+        if (is(kind::name) and m_lexer.colon_follows()) {
+            m_lexer.advance();
+            m_lexer.advance();
+        }
+    }
+
+    void objective(double sense)
+    {
+        label();
+        expression();
+
+        for (const auto &term : m_terms)
+            m_state.c[term.first] += static_cast<mitm::real>(sense *
+                                                             term.second);
+    }
+
+    /// Reads a constraint `expr op value' or `value op expr op value'.
+    void constraint()
+    {
+        const int line = m_lexer.current().line;
+
+        label();
+        double constant = expression();
+        double lower = -infinity;
+        double upper = infinity;
+
+        if (not is_comparison())
+            m_lexer.error("comparison expected");
+
+        if (m_terms.empty()) {
+            const kind first = m_lexer.current().type;
+            m_lexer.advance();
+            const double bound = constant;
+            constant = expression();
+
+            if (first == kind::less)
+                lower = bound - constant;
+            else if (first == kind::greater)
+                upper = bound - constant;
+            else
+                m_lexer.error("range expected");
+
+            if (not is(first))
+                m_lexer.error("range expected");
+        }
+
+        const kind type = m_lexer.current().type;
+        m_lexer.advance();
+        const double rhs = value() - constant;
+
+        if (type != kind::greater)
+            upper = rhs;
+        if (type != kind::less)
+            lower = rhs;
+
+        // The terms of a same column are merged, the columns of a row are
+        // increasing.
+        std::sort(m_terms.begin(), m_terms.end(),
+                  [](const std::pair<mitm::index, double> &lhs,
+                     const std::pair<mitm::index, double> &rhs)
+                  {
+                      return lhs.first < rhs.first;
+                  });
+
+        for (auto it = m_terms.cbegin(); it != m_terms.cend();) {
+            const mitm::index j = it->first;
+            double sum = 0;
+            for (; it != m_terms.cend() and it->first == j; ++it)
+                sum += it->second;
+
+            if (sum != 0) {
+                m_state.cols_index.push_back(j);
+                m_state.values.push_back(to_coefficient(sum, line));
+            }
+        }
+
+        m_state.rows_ptr.push_back(
+            static_cast<mitm::index>(m_state.cols_index.size()));
+        m_lower.push_back(lower);
+        m_upper.push_back(upper);
+    }
+
+    /// Reads a bound `name op value', `value op name [op value]' or
+    /// `name free'.
+    void bound()
+    {
+        const int line = m_lexer.current().line;
+
+        if (is(kind::name) and not m_lexer.current().w.is_keyword("inf") and
+            not m_lexer.current().w.is_keyword("infinity")) {
+            column();
+
+            if (is(kind::name) and m_lexer.current().w.is_keyword("free"))
+                m_lexer.error("only binary variables are supported");
+
+            if (not is_comparison())
+                m_lexer.error("comparison expected");
+
+            const kind type = m_lexer.current().type;
+            m_lexer.advance();
+            const double bound = value();
+
+            if (type != kind::greater)
+                check_bound(false, bound, line);
+            if (type != kind::less)
+                check_bound(true, bound, line);
+
+            return;
+        }
+
+        const double first = value();
+        if (not is_comparison())
+            m_lexer.error("comparison expected");
+
+        const kind type = m_lexer.current().type;
+        m_lexer.advance();
+
+        if (not is(kind::name))
+            m_lexer.error("variable expected");
+        column();
+
+        if (type != kind::greater)
+            check_bound(true, first, line);
+        if (type != kind::less)
+            check_bound(false, first, line);
+
+        if (is_comparison()) {
+            const kind second = m_lexer.current().type;
+            m_lexer.advance();
+            const double bound = value();
+
+            if (second != kind::greater)
+                check_bound(false, bound, line);
+            if (second != kind::less)
+                check_bound(true, bound, line);
+        }
+    }
+
+public:
+    lp_reader(const char *first, const char *last, mitm::SparseState &s)
+        : m_lexer(first, last)
+        , m_state(s)
+        , m_sense(1)
+    {
+        s.rows_ptr.assign(1, 0);
+        s.cols_index.clear();
+        s.values.clear();
+        s.c.clear();
+    }
+
+    void read()
+    {
+        section current = section::none;
+
+        while (current != section::end and not is(kind::end)) {
+            double sense;
+            const section next = keyword(sense);
+
+            if (next != section::none) {
+                current = next;
+                m_lexer.advance();
+
+                if (current == section::objective) {
+                    m_sense = sense;
+                    objective(m_sense);
+                } else if (current == section::constraints and
+                           is(kind::name) and
+                           (m_lexer.current().w.is_keyword("to") or
+                            m_lexer.current().w.is_keyword("that"))) {
+                    m_lexer.advance();
+                }
+
+                continue;
+            }
+
+            switch (current) {
+            case section::constraints:
+                constraint();
+                break;
+            case section::bounds:
+                bound();
+                break;
+            case section::binary:
+                if (not is(kind::name))
+                    m_lexer.error("variable expected");
+                column();
+                break;
+            default:
+                m_lexer.error("section expected");
+            }
+        }
+
+        finish(m_state, m_lower, m_upper, m_lexer.current().line);
+    }
+};
+
+} // anonymous namespace
+
+namespace mitm {
+
+void load_mps(const std::string &filename, SparseState &s)
+{
+    load_mps(filename, s, chunk_policy());
+}
+
+void load_mps(const std::string &filename, SparseState &s,
+              const chunk_policy &policy)
+{
+    mitm::mapped_file file(filename.c_str());
+
+    ::read_mps(file.data(), file.data() + file.size(), s, policy);
+}
+
+void load_lp(const std::string &filename, SparseState &s)
+{
+    mitm::mapped_file file(filename.c_str());
+    ::lp_reader reader(file.data(), file.data() + file.size(), s);
+
+    reader.read();
+}
+
+} // namespace mitm
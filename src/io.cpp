@@ -23,7 +23,13 @@
 #include <mitm/mitm.hpp>
 #include "assert.hpp"
 #include "internal.hpp"
+#include "mapped-file.hpp"
+#include "text-chunks.hpp"
+#include "text-scanner.hpp"
+#include <algorithm>
 #include <istream>
+#include <limits>
+#include <vector>
 
 namespace {
 
@@ -81,6 +87,191 @@ T next_token(std::istream &is, int &lineid)
     throw mitm::io_error("fail to read stream", lineid);
 }
 
+void read_dimensions(mitm::text_scanner &scanner,
+                     mitm::index &m, mitm::index &n)
+{
+    m = scanner.next_integer<mitm::index>();
+    n = scanner.next_integer<mitm::index>();
+
+    if (m <= 0 or n <= 0)
+        scanner.error("m and n must be greater than 0");
+}
+
+void read_vectors(mitm::text_scanner &scanner, std::vector<int> &b,
+                  std::vector<mitm::real> &c)
+{
+    for (auto &value : b)
+        value = scanner.next_integer<int>();
+
+    for (auto &value : c)
+        value = scanner.next_real<mitm::real>();
+}
+
+/// Format 0: the dense matrix, only the non zero coefficients are kept.
+void read_dense(mitm::text_scanner &scanner, mitm::SparseState &s)
+{
+    const mitm::index m = s.constraints();
+    const mitm::index n = s.variables();
+
+    for (mitm::index i = 0; i != m; ++i) {
+        for (mitm::index j = 0; j != n; ++j)
+            if (scanner.next_bool())
+                s.cols_index.push_back(j);
+
+        s.rows_ptr[i + 1] = static_cast<mitm::index>(s.cols_index.size());
+    }
+}
+
+/// Format 1: for each constraint, the number of variables then their
+/// columns. @e stamp remembers the last row of each column to detect a
+/// column repeated in a constraint.
+void read_rows(mitm::token_chunks::cursor &tokens, mitm::SparseState &s)
+{
+    const mitm::index m = s.constraints();
+    const mitm::index n = s.variables();
+    std::vector<mitm::index> stamp(n, -1);
+
+    for (mitm::index i = 0; i != m; ++i) {
+        const mitm::index length = tokens.next<mitm::index>();
+
+        if (length < 0 or length > n)
+            tokens.error("bad number of variables in a constraint");
+
+        for (mitm::index k = 0; k != length; ++k) {
+            const mitm::index j = tokens.next<mitm::index>();
+
+            if (j < 0 or j >= n)
+                tokens.error("column out of range");
+
+            if (stamp[j] == i)
+                tokens.error("column repeated in a constraint");
+
+            stamp[j] = i;
+            s.cols_index.push_back(j);
+        }
+
+        s.rows_ptr[i + 1] = static_cast<mitm::index>(s.cols_index.size());
+    }
+}
+
+/// Format 2: the number of coefficients then the `i j value' triplets in
+/// any order, gathered in rows by a counting sort. The zero coefficients
+/// are dropped and the values are kept only if one of them is not 1.
+void read_triplets(const mitm::token_chunks &chunks,
+                   mitm::token_chunks::cursor &tokens, mitm::SparseState &s)
+{
+    struct triplet
+    {
+        mitm::index i;
+        mitm::index j;
+        int value;
+        std::size_t rank;   ///< of the token i, for the error line.
+    };
+
+    const mitm::index m = s.constraints();
+    const mitm::index n = s.variables();
+    const mitm::index nnz = tokens.next<mitm::index>();
+
+    if (nnz < 0 or nnz / m > n)
+        tokens.error("bad number of coefficients");
+
+    std::vector<triplet> triplets;
+    triplets.reserve(nnz);
+    bool ones = true;
+
+    for (mitm::index k = 0; k != nnz; ++k) {
+        triplet t;
+        t.rank = tokens.rank();
+        t.i = tokens.next<mitm::index>();
+        t.j = tokens.next<mitm::index>();
+        t.value = tokens.next<int>();
+
+        if (t.i < 0 or t.i >= m)
+            tokens.error("row out of range");
+
+        if (t.j < 0 or t.j >= n)
+            tokens.error("column out of range");
+
+        if (t.value == 0)
+            continue;
+
+        ones = ones and t.value == 1;
+        ++s.rows_ptr[t.i + 1];
+        triplets.push_back(t);
+    }
+
+    for (mitm::index i = 0; i != m; ++i)
+        s.rows_ptr[i + 1] += s.rows_ptr[i];
+
+    // The counting sort keeps the order of the file in a row, a repeated
+    // column is reported at the line of its second triplet.
+    std::vector<mitm::index> cursor(s.rows_ptr.begin(), s.rows_ptr.end() - 1);
+    std::vector<std::size_t> order(triplets.size());
+
+    for (std::size_t k = 0, e = triplets.size(); k != e; ++k)
+        order[cursor[triplets[k].i]++] = k;
+
+    std::vector<mitm::index> stamp(n, -1);
+    s.cols_index.resize(triplets.size());
+    if (not ones)
+        s.values.resize(triplets.size());
+
+    for (mitm::index i = 0; i != m; ++i) {
+        for (mitm::index pos = s.rows_ptr[i]; pos != s.rows_ptr[i + 1];
+             ++pos) {
+            const triplet &t = triplets[order[pos]];
+
+            if (stamp[t.j] == i)
+                chunks.error(t.rank, "column repeated in a constraint");
+
+            stamp[t.j] = i;
+            s.cols_index[pos] = t.j;
+            if (not ones)
+                s.values[pos] = t.value;
+        }
+    }
+}
+
+/** Reads the model after the format index. The sparse formats are split
+ * in chunks converted in parallel then read in order. Returns the line
+ * after the model.
+ */
+int read_sparse(mitm::text_scanner &scanner, const char *last, int format,
+                mitm::SparseState &s, const mitm::chunk_policy &policy)
+{
+    if (format < 0 or format > 2)
+        scanner.error("unknown format (0, 1 or 2 expected)");
+
+    mitm::index m, n;
+    ::read_dimensions(scanner, m, n);
+
+    if (s.init(m, n))
+        scanner.error("not enough memory");
+
+    if (format == 0) {
+        ::read_dense(scanner, s);
+        ::read_vectors(scanner, s.b, s.c);
+
+        return scanner.line();
+    }
+
+    mitm::token_chunks chunks(scanner.position(), last, scanner.line(),
+                              policy);
+    mitm::token_chunks::cursor tokens(chunks);
+
+    if (format == 1)
+        ::read_rows(tokens, s);
+    else
+        ::read_triplets(chunks, tokens, s);
+
+    for (auto &value : s.b)
+        value = tokens.next<int>();
+
+    chunks.reals(tokens.rank(), s.c.size(), s.c.data());
+
+    return chunks.line(tokens.rank() + s.c.size() - 1);
+}
+
 } // anonymous namespace
 
 namespace mitm {
@@ -120,7 +311,7 @@ std::istream &operator>>(std::istream &is, mitm::SimpleState &s)
 
     for (mitm::index i = 0; i != m; ++i)
         for (mitm::index j = 0; j != n; ++j)
-            s.a[i * m + j] = ::next_token<bool>(is, lineid);
+            s.a[i * n + j] = ::next_token<bool>(is, lineid);
 
     for (mitm::index i = 0; i != m; ++i)
         s.b[i] = ::next_token<int>(is, lineid);
@@ -131,4 +322,72 @@ std::istream &operator>>(std::istream &is, mitm::SimpleState &s)
     return is;
 }
 
+void load(const std::string &filename, SimpleState &s)
+{
+    mitm::mapped_file file(filename.c_str());
+    mitm::text_scanner scanner(file.data(), file.data() + file.size());
+
+    const int format = scanner.next_integer<int>();
+    if (format == 0) {
+        mitm::index m, n;
+        ::read_dimensions(scanner, m, n);
+
+        if (m > std::numeric_limits<mitm::index>::max() / n)
+            scanner.error("overflow m*n overflow mitm::index");
+
+        if (s.init(m, n))
+            scanner.error("not enough memory");
+
+        for (mitm::index i = 0; i != m; ++i)
+            for (mitm::index j = 0; j != n; ++j)
+                s.a[i * n + j] = scanner.next_bool();
+
+        ::read_vectors(scanner, s.b, s.c);
+        return;
+    }
+
+    // The sparse formats are read in compressed rows then expanded, the
+    // dense matrix of a SimpleState only stores 0/1 coefficients.
+    SparseState sparse;
+    const int line = ::read_sparse(scanner, file.data() + file.size(),
+                                   format, sparse, chunk_policy());
+
+    const mitm::index m = sparse.constraints();
+    const mitm::index n = sparse.variables();
+
+    if (m > std::numeric_limits<mitm::index>::max() / n)
+        throw io_error("overflow m*n overflow mitm::index", line);
+
+    for (int value : sparse.values)
+        if (value != 1)
+            throw io_error("coefficient must be 1 in a dense state", line);
+
+    if (s.init(m, n))
+        throw io_error("not enough memory", line);
+
+    std::fill(s.a.begin(), s.a.end(), false);
+    for (mitm::index i = 0; i != m; ++i)
+        for (mitm::index pos = sparse.rows_ptr[i];
+             pos != sparse.rows_ptr[i + 1]; ++pos)
+            s.a[i * n + sparse.cols_index[pos]] = true;
+
+    s.b.swap(sparse.b);
+    s.c.swap(sparse.c);
+}
+
+void load(const std::string &filename, SparseState &s)
+{
+    load(filename, s, chunk_policy());
+}
+
+void load(const std::string &filename, SparseState &s,
+          const chunk_policy &policy)
+{
+    mitm::mapped_file file(filename.c_str());
+    mitm::text_scanner scanner(file.data(), file.data() + file.size());
+
+    const int format = scanner.next_integer<int>();
+    ::read_sparse(scanner, file.data() + file.size(), format, s, policy);
+}
+
 } // namespace mitm
@@ -0,0 +1,580 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "kernels.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MITM_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace mitm {
+namespace {
+
+//
+// scalar kernels, the reference of the other instruction sets.
+//
+
+template <typename Real, typename Index>
+void
+scalar_reduced_costs(const Real *c, Real *u, const Index *I, const int *a,
+                     const Real *p, Real factor, Real *out, Index size)
+{
+    for (Index i = 0; i != size; ++i) {
+        const Index j = I[i];
+
+        u[j] += static_cast<Real>(a[i]) * p[i] * factor;
+        out[i] = c[j] - u[j];
+    }
+}
+
+template <typename Real, typename Index>
+basic_min2<Real>
+scalar_select_min2(const Real *values, Index size)
+{
+    return select_min2(values, size);
+}
+
+template <typename Real, typename Index>
+Index
+scalar_count_less(const Real *values, Index size, Real threshold)
+{
+    Index ret = 0;
+
+    for (Index i = 0; i != size; ++i)
+        ret += values[i] < threshold;
+
+    return ret;
+}
+
+template <typename Real, typename Index>
+void
+scalar_add_row(Real *p, Real p_value, Real *u, const Index *I, const int *a,
+               Real u_value, Index size)
+{
+    for (Index i = 0; i != size; ++i) {
+        p[i] += p_value;
+        u[I[i]] += static_cast<Real>(a[i]) * u_value;
+    }
+}
+
+template <typename Real, typename Index>
+const basic_kernel_table<Real, Index>*
+scalar_kernels()
+{
+    static const basic_kernel_table<Real, Index> table = {
+        "scalar",
+        scalar_reduced_costs<Real, Index>,
+        scalar_select_min2<Real, Index>,
+        scalar_count_less<Real, Index>,
+        scalar_add_row<Real, Index>
+    };
+
+    return &table;
+}
+
+/// The SIMD kernels supported by the CPU, none by default.
+template <typename Real, typename Index>
+struct simd_kernels
+{
+    static void
+    append(std::vector<const basic_kernel_table<Real, Index>*>&)
+    {}
+};
+
+#ifdef MITM_HAVE_X86_KERNELS
+
+/// Continue the scalar search of the two smallest values with the state
+/// @e ret from the position @e i.
+basic_min2<float>
+select_min2_tail(const float *values, index i, index size,
+                 basic_min2<float> ret)
+{
+    for (; i != size; ++i) {
+        const float v = values[i];
+        const bool lower = v < ret.first;
+
+        ret.second = lower ? ret.first : std::min(ret.second, v);
+        ret.position = lower ? i : ret.position;
+        ret.first = lower ? v : ret.first;
+    }
+
+    return ret;
+}
+
+/// Merge the search state of a lane into @e ret. On equal minimum, the
+/// lowest position wins as in the scalar search.
+void
+merge_min2(basic_min2<float> &ret, float first, float second,
+           index position)
+{
+    if (first < ret.first or (first == ret.first and
+                              position < ret.position)) {
+        ret.second = std::min(ret.first, second);
+        ret.first = first;
+        ret.position = position;
+    } else {
+        ret.second = std::min(ret.second, first);
+    }
+}
+
+//
+// AVX2 kernels: 8 floats per loop. The gathers use one 8 x 32 bits or two
+// 4 x 64 bits indices vectors, the scatters are scalar stores.
+//
+
+__attribute__((target("avx2")))
+inline __m256
+avx2_gather(const float *base, const std::int32_t *I)
+{
+    return _mm256_i32gather_ps(
+        base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(I)), 4);
+}
+
+__attribute__((target("avx2")))
+inline __m256
+avx2_gather(const float *base, const std::int64_t *I)
+{
+    const __m256i lo = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(I));
+    const __m256i hi = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(I + 4));
+
+    return _mm256_set_m128(_mm256_i64gather_ps(base, hi, 4),
+                           _mm256_i64gather_ps(base, lo, 4));
+}
+
+template <typename Index>
+__attribute__((target("avx2")))
+inline void
+avx2_scatter(float *base, const Index *I, __m256 values)
+{
+    alignas(32) float tmp[8];
+    _mm256_store_ps(tmp, values);
+
+    for (int l = 0; l != 8; ++l)
+        base[I[l]] = tmp[l];
+}
+
+__attribute__((target("avx2")))
+inline __m256
+avx2_load_coefficients(const int *a)
+{
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256(
+                                  reinterpret_cast<const __m256i*>(a)));
+}
+
+template <typename Index>
+__attribute__((target("avx2")))
+void
+avx2_reduced_costs(const float *c, float *u, const Index *I, const int *a,
+                   const float *p, float factor, float *out, Index size)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    Index i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        const __m256 cj = avx2_gather(c, I + i);
+        const __m256 uj = avx2_gather(u, I + i);
+        const __m256 du = _mm256_mul_ps(
+            _mm256_mul_ps(avx2_load_coefficients(a + i),
+                          _mm256_loadu_ps(p + i)), f);
+        const __m256 un = _mm256_add_ps(uj, du);
+
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(cj, un));
+        avx2_scatter(u, I + i, un);
+    }
+
+    scalar_reduced_costs(c, u, I + i, a + i, p + i, factor, out + i,
+                         static_cast<Index>(size - i));
+}
+
+template <typename Index>
+__attribute__((target("avx2")))
+basic_min2<float>
+avx2_select_min2(const float *values, Index size)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    basic_min2<float> ret { inf, inf, 0 };
+
+    if (size < 16)
+        return select_min2_tail(values, 0, size, ret);
+
+    __m256 first = _mm256_set1_ps(inf);
+    __m256 second = _mm256_set1_ps(inf);
+    __m256i position = _mm256_setzero_si256();
+    __m256i current = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    index i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        const __m256 v = _mm256_loadu_ps(values + i);
+        const __m256 lower = _mm256_cmp_ps(v, first, _CMP_LT_OQ);
+
+        second = _mm256_blendv_ps(_mm256_min_ps(v, second), first, lower);
+        position = _mm256_castps_si256(
+            _mm256_blendv_ps(_mm256_castsi256_ps(position),
+                             _mm256_castsi256_ps(current), lower));
+        first = _mm256_blendv_ps(first, v, lower);
+        current = _mm256_add_epi32(current, step);
+    }
+
+    alignas(32) float firsts[8];
+    alignas(32) float seconds[8];
+    alignas(32) int positions[8];
+    _mm256_store_ps(firsts, first);
+    _mm256_store_ps(seconds, second);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(positions), position);
+
+    for (int l = 0; l != 8; ++l)
+        merge_min2(ret, firsts[l], seconds[l], positions[l]);
+
+    return select_min2_tail(values, i, size, ret);
+}
+
+template <typename Index>
+__attribute__((target("avx2")))
+Index
+avx2_count_less(const float *values, Index size, float threshold)
+{
+    const __m256 t = _mm256_set1_ps(threshold);
+    Index ret = 0;
+    Index i = 0;
+
+    for (; i + 8 <= size; i += 8)
+        ret += __builtin_popcount(_mm256_movemask_ps(
+            _mm256_cmp_ps(_mm256_loadu_ps(values + i), t, _CMP_LT_OQ)));
+
+    return ret + scalar_count_less(values + i, static_cast<Index>(size - i),
+                                   threshold);
+}
+
+template <typename Index>
+__attribute__((target("avx2")))
+void
+avx2_add_row(float *p, float p_value, float *u, const Index *I,
+             const int *a, float u_value, Index size)
+{
+    const __m256 pv = _mm256_set1_ps(p_value);
+    const __m256 uv = _mm256_set1_ps(u_value);
+    Index i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        _mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_loadu_ps(p + i), pv));
+
+        const __m256 un = _mm256_add_ps(
+            avx2_gather(u, I + i),
+            _mm256_mul_ps(avx2_load_coefficients(a + i), uv));
+        avx2_scatter(u, I + i, un);
+    }
+
+    scalar_add_row(p + i, p_value, u, I + i, a + i, u_value,
+                   static_cast<Index>(size - i));
+}
+
+//
+// AVX-512 kernels: the gathers and scatters are native, 16 floats per loop
+// with 32 bits indices and 8 floats with 64 bits indices. The searches use
+// 16 floats per loop and mask registers.
+//
+// The plain gathers, conversions and min of GCC start from an undefined
+// register and -O3 warns with -Wmaybe-uninitialized: the helpers below use
+// the masked forms from a zero register instead, with a full mask.
+//
+
+__attribute__((target("avx512f")))
+inline __m512
+avx512_gather(const float *base, __m512i idx)
+{
+    return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, idx, base,
+                                    4);
+}
+
+__attribute__((target("avx512f")))
+inline __m256
+avx512_gather8(const float *base, __m512i idx)
+{
+    return _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xFF, idx, base,
+                                    4);
+}
+
+__attribute__((target("avx512f")))
+inline __m512
+avx512_load_coefficients(const int *a)
+{
+    return _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_loadu_si512(a));
+}
+
+__attribute__((target("avx512f")))
+void
+avx512_reduced_costs(const float *c, float *u, const std::int32_t *I,
+                     const int *a, const float *p, float factor, float *out,
+                     std::int32_t size)
+{
+    const __m512 f = _mm512_set1_ps(factor);
+    std::int32_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        const __m512i idx = _mm512_loadu_si512(I + i);
+        const __m512 cj = avx512_gather(c, idx);
+        const __m512 uj = avx512_gather(u, idx);
+        const __m512 av = avx512_load_coefficients(a + i);
+        const __m512 du = _mm512_mul_ps(
+            _mm512_mul_ps(av, _mm512_loadu_ps(p + i)), f);
+        const __m512 un = _mm512_add_ps(uj, du);
+
+        _mm512_storeu_ps(out + i, _mm512_sub_ps(cj, un));
+        _mm512_i32scatter_ps(u, idx, un, 4);
+    }
+
+    scalar_reduced_costs(c, u, I + i, a + i, p + i, factor, out + i,
+                         size - i);
+}
+
+__attribute__((target("avx512f")))
+void
+avx512_reduced_costs(const float *c, float *u, const std::int64_t *I,
+                     const int *a, const float *p, float factor, float *out,
+                     std::int64_t size)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    std::int64_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        const __m512i idx = _mm512_loadu_si512(I + i);
+        const __m256 cj = avx512_gather8(c, idx);
+        const __m256 uj = avx512_gather8(u, idx);
+        const __m256 av = _mm256_cvtepi32_ps(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+        const __m256 du = _mm256_mul_ps(
+            _mm256_mul_ps(av, _mm256_loadu_ps(p + i)), f);
+        const __m256 un = _mm256_add_ps(uj, du);
+
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(cj, un));
+        _mm512_i64scatter_ps(u, idx, un, 4);
+    }
+
+    scalar_reduced_costs(c, u, I + i, a + i, p + i, factor, out + i,
+                         size - i);
+}
+
+template <typename Index>
+__attribute__((target("avx512f")))
+basic_min2<float>
+avx512_select_min2(const float *values, Index size)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    basic_min2<float> ret { inf, inf, 0 };
+
+    if (size < 32)
+        return select_min2_tail(values, 0, size, ret);
+
+    __m512 first = _mm512_set1_ps(inf);
+    __m512 second = _mm512_set1_ps(inf);
+    __m512i position = _mm512_setzero_si512();
+    __m512i current = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i step = _mm512_set1_epi32(16);
+    index i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        const __m512 v = _mm512_loadu_ps(values + i);
+        const __mmask16 lower = _mm512_cmp_ps_mask(v, first, _CMP_LT_OQ);
+
+        second = _mm512_mask_blend_ps(
+            lower, _mm512_maskz_min_ps(0xFFFF, v, second), first);
+        position = _mm512_mask_blend_epi32(lower, position, current);
+        first = _mm512_mask_blend_ps(lower, first, v);
+        current = _mm512_add_epi32(current, step);
+    }
+
+    alignas(64) float firsts[16];
+    alignas(64) float seconds[16];
+    alignas(64) int positions[16];
+    _mm512_store_ps(firsts, first);
+    _mm512_store_ps(seconds, second);
+    _mm512_store_si512(positions, position);
+
+    for (int l = 0; l != 16; ++l)
+        merge_min2(ret, firsts[l], seconds[l], positions[l]);
+
+    return select_min2_tail(values, i, size, ret);
+}
+
+template <typename Index>
+__attribute__((target("avx512f")))
+Index
+avx512_count_less(const float *values, Index size, float threshold)
+{
+    const __m512 t = _mm512_set1_ps(threshold);
+    Index ret = 0;
+    Index i = 0;
+
+    for (; i + 16 <= size; i += 16)
+        ret += __builtin_popcount(_mm512_cmp_ps_mask(
+                                      _mm512_loadu_ps(values + i), t,
+                                      _CMP_LT_OQ));
+
+    return ret + scalar_count_less(values + i, static_cast<Index>(size - i),
+                                   threshold);
+}
+
+__attribute__((target("avx512f")))
+void
+avx512_add_row(float *p, float p_value, float *u, const std::int32_t *I,
+               const int *a, float u_value, std::int32_t size)
+{
+    const __m512 pv = _mm512_set1_ps(p_value);
+    const __m512 uv = _mm512_set1_ps(u_value);
+    std::int32_t i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        _mm512_storeu_ps(p + i, _mm512_add_ps(_mm512_loadu_ps(p + i), pv));
+
+        const __m512i idx = _mm512_loadu_si512(I + i);
+        const __m512 un = _mm512_add_ps(
+            avx512_gather(u, idx),
+            _mm512_mul_ps(avx512_load_coefficients(a + i), uv));
+        _mm512_i32scatter_ps(u, idx, un, 4);
+    }
+
+    scalar_add_row(p + i, p_value, u, I + i, a + i, u_value, size - i);
+}
+
+__attribute__((target("avx512f")))
+void
+avx512_add_row(float *p, float p_value, float *u, const std::int64_t *I,
+               const int *a, float u_value, std::int64_t size)
+{
+    const __m256 pv = _mm256_set1_ps(p_value);
+    const __m256 uv = _mm256_set1_ps(u_value);
+    std::int64_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        _mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_loadu_ps(p + i), pv));
+
+        const __m512i idx = _mm512_loadu_si512(I + i);
+        const __m256 av = _mm256_cvtepi32_ps(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+        const __m256 un = _mm256_add_ps(avx512_gather8(u, idx),
+                                        _mm256_mul_ps(av, uv));
+        _mm512_i64scatter_ps(u, idx, un, 4);
+    }
+
+    scalar_add_row(p + i, p_value, u, I + i, a + i, u_value, size - i);
+}
+
+template <typename Index>
+struct simd_kernels<float, Index>
+{
+    static void
+    append(std::vector<const basic_kernel_table<float, Index>*>& ret)
+    {
+        static const basic_kernel_table<float, Index> avx2 = {
+            "avx2",
+            avx2_reduced_costs<Index>,
+            avx2_select_min2<Index>,
+            avx2_count_less<Index>,
+            avx2_add_row<Index>
+        };
+
+        static const basic_kernel_table<float, Index> avx512 = {
+            "avx512",
+            avx512_reduced_costs,
+            avx512_select_min2<Index>,
+            avx512_count_less<Index>,
+            avx512_add_row
+        };
+
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+            ret.emplace_back(&avx2);
+
+        if (__builtin_cpu_supports("avx512f"))
+            ret.emplace_back(&avx512);
+    }
+};
+
+#endif
+
+template <typename Real, typename Index>
+const basic_kernel_table<Real, Index>*
+select_kernels()
+{
+    const auto available = available_kernels<Real, Index>();
+    const char *name = std::getenv("MITM_KERNELS");
+
+    if (name)
+        for (auto elem : available)
+            if (std::strcmp(elem->name, name) == 0)
+                return elem;
+
+    return available.back();
+}
+
+} // anonymous namespace
+
+template <typename Real, typename Index>
+std::vector<const basic_kernel_table<Real, Index>*>
+available_kernels()
+{
+    std::vector<const basic_kernel_table<Real, Index>*> ret {
+        scalar_kernels<Real, Index>() };
+
+    simd_kernels<Real, Index>::append(ret);
+
+    return ret;
+}
+
+template <typename Real, typename Index>
+const basic_kernel_table<Real, Index>&
+kernels() noexcept
+{
+    static const basic_kernel_table<Real, Index> *ret =
+        select_kernels<Real, Index>();
+
+    return *ret;
+}
+
+template std::vector<const basic_kernel_table<float, std::int32_t>*>
+available_kernels<float, std::int32_t>();
+template std::vector<const basic_kernel_table<float, std::int64_t>*>
+available_kernels<float, std::int64_t>();
+template std::vector<const basic_kernel_table<double, std::int32_t>*>
+available_kernels<double, std::int32_t>();
+template std::vector<const basic_kernel_table<double, std::int64_t>*>
+available_kernels<double, std::int64_t>();
+
+template const basic_kernel_table<float, std::int32_t>&
+kernels<float, std::int32_t>() noexcept;
+template const basic_kernel_table<float, std::int64_t>&
+kernels<float, std::int64_t>() noexcept;
+template const basic_kernel_table<double, std::int32_t>&
+kernels<double, std::int32_t>() noexcept;
+template const basic_kernel_table<double, std::int64_t>&
+kernels<double, std::int64_t>() noexcept;
+
+} // namespace mitm
@@ -0,0 +1,200 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_KERNELS_HPP
+#define FR_INRA_MITM_KERNELS_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+namespace mitm {
+
+/** Under this number of selected elements, select_bk uses a bounded heap
+ * instead of an introselect.
+ */
+constexpr index select_bk_heap_limit = 8;
+
+/// The reduced cost of a selection element: the value itself or the first
+/// element of a tuple (reduced cost, identifier).
+template <typename Real>
+inline typename std::enable_if<std::is_floating_point<Real>::value,
+                               Real>::type
+reduced_cost(Real value) noexcept
+{
+    return value;
+}
+
+template <typename Real, typename Identifier>
+inline Real
+reduced_cost(const std::tuple<Real, Identifier>& value) noexcept
+{
+    return std::get<0>(value);
+}
+
+/** Reorder the reduced costs [first, last[ so that the @e bk first elements
+ * are the bk smallest ones and return the values that std::sort would have
+ * put at the positions bk - 1 and bk.
+ *
+ * The elements are reduced costs or tuples (reduced cost, identifier) and
+ * only the reduced cost is compared. Expected complexity is
+ * O(last - first).
+ */
+template <typename Iterator>
+auto
+select_bk(Iterator first, Iterator last, index bk)
+    -> std::pair<decltype(reduced_cost(*first)),
+                 decltype(reduced_cost(*first))>
+{
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+    assert(bk > 0 && bk < std::distance(first, last));
+
+    auto compare = [](const value_type& lhs, const value_type& rhs)
+        {
+            return reduced_cost(lhs) < reduced_cost(rhs);
+        };
+
+    if (bk < select_bk_heap_limit) {
+        std::partial_sort(first, first + bk + 1, last, compare);
+
+        return std::make_pair(reduced_cost(*(first + bk - 1)),
+                              reduced_cost(*(first + bk)));
+    }
+
+    std::nth_element(first, first + bk, last, compare);
+    auto max = std::max_element(first, first + bk, compare);
+
+    return std::make_pair(reduced_cost(*max), reduced_cost(*(first + bk)));
+}
+
+/** The two smallest values of a buffer and the position of the smallest.
+ */
+template <typename Real>
+struct basic_min2
+{
+    Real first;
+    Real second;
+    index position;
+};
+
+using min2 = basic_min2<real>;
+
+/** Single pass search of the two smallest values of [values, values + size[.
+ *
+ * It is the kernel of the set partitioning rows (bk = 1) where only the
+ * minimum and second minimum reduced costs are needed. The loop carries
+ * first, second and position from one value to the next, compilers do not
+ * vectorize it: the AVX2 and AVX-512 kernels keep the search state per
+ * lane and merge the lanes at the end.
+ */
+template <typename Real>
+inline basic_min2<Real>
+select_min2(const Real *values, index size) noexcept
+{
+    assert(size >= 2);
+
+    Real first = std::numeric_limits<Real>::infinity();
+    Real second = std::numeric_limits<Real>::infinity();
+    index position = 0;
+
+    for (index i = 0; i != size; ++i) {
+        const Real v = values[i];
+        const bool lower = v < first;
+
+        second = lower ? first : std::min(second, v);
+        position = lower ? i : position;
+        first = lower ? v : first;
+    }
+
+    return { first, second, position };
+}
+
+/** basic_kernel_table gathers the kernels of the constraint update for one
+ * instruction set, @e Real reduced costs and @e Index positions. A row k
+ * of the constraints matrix is given by @e I, the columns, and @e a, the
+ * coefficients, of its CSR arrays and @e p is the stored row of the
+ * penalty matrix. The reduced costs are computed in a values buffer
+ * separated from the identifiers (structure of arrays).
+ *
+ * In a row, the columns are distinct so the scatters to @e u never
+ * conflict.
+ */
+template <typename Real, typename Index>
+struct basic_kernel_table
+{
+    const char *name;
+
+    /// Apply the theta decay of the row to u, u[I[i]] += a[i] * p[i] *
+    /// factor, then out[i] = c[I[i]] - u[I[i]].
+    void (*reduced_costs)(const Real *c, Real *u, const Index *I,
+                          const int *a, const Real *p, Real factor,
+                          Real *out, Index size);
+
+    /// Same result as select_min2() (size >= 2).
+    basic_min2<Real> (*select_min2)(const Real *values, Index size);
+
+    /// Number of values strictly lower than @e threshold.
+    Index (*count_less)(const Real *values, Index size, Real threshold);
+
+    /// p[i] += p_value and u[I[i]] += a[i] * u_value.
+    void (*add_row)(Real *p, Real p_value, Real *u, const Index *I,
+                    const int *a, Real u_value, Index size);
+};
+
+using kernel_table = basic_kernel_table<real, index>;
+
+/** The kernels of the best instruction set of the CPU, selected at the
+ * first call. The environment variable MITM_KERNELS (scalar, avx2 or
+ * avx512) forces an available instruction set.
+ *
+ * Instantiated for float and double reduced costs and std::int32_t and
+ * std::int64_t positions. The SIMD kernels exist only for float.
+ */
+template <typename Real, typename Index>
+const basic_kernel_table<Real, Index>& kernels() noexcept;
+
+/// All the kernels supported by the CPU, the scalar ones first.
+template <typename Real, typename Index>
+std::vector<const basic_kernel_table<Real, Index>*> available_kernels();
+
+inline const kernel_table&
+kernels() noexcept
+{
+    return kernels<real, index>();
+}
+
+inline std::vector<const kernel_table*>
+available_kernels()
+{
+    return available_kernels<real, index>();
+}
+
+} // namespace mitm
+
+#endif
@@ -21,10 +21,11 @@
  */
 
 #include <mitm/mitm.hpp>
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <climits>
 #include <cmath>
 #include <getopt.h>
@@ -35,13 +36,19 @@ void
 help_show() noexcept
 {
     std::cout << "mitm [options...]\n"
-              << "-m method    h_classic, h_gpgpu\n"
+              << "-m method    classic, parallel, portfolio, gpgpu\n"
               << "-l limit     number of loop\n"
+              << "-T seconds   time limit of each solve (float)\n"
               << "-k kappa     kappa init value [0..1[ (float)\n"
               << "-d delta     delta value [0..+oo[ (float)\n"
               << "-t theta     theta value [0..1] (float)\n"
+              << "-s schedule  constant, geometric, violation, annealing\n"
+              << "-o order     all, worklist, violation\n"
+              << "-u           use binary models without checking their"
+              << " checksum\n"
               << '\n'
-              << "File format: (text file)\n"
+              << "File format: (text file, .mps, .lp or binary model written"
+              << " by mitm-convert)\n"
               << " # ... are comments\n"
               << " [format (int), default 0]\n"
               << " [m constraints (int)] [n variables (int)]\n"
@@ -55,9 +62,69 @@ help_show() noexcept
               << "1 0 0 1 1 1     # 2*3 constraints matrix A\n"
               << "1 1             # 2 vector B\n"
               << "27.3 48.1 0.19  # 3 vector C (costs)\n"
+              << '\n'
+              << "Format 1, the variables of each constraint:\n"
+              << "1               # model index\n"
+              << "2 3             # constraints and variables numbers\n"
+              << "1 0             # constraint 0: 1 variable, column 0\n"
+              << "2 1 2           # constraint 1: 2 variables, 1 and 2\n"
+              << "1 1             # 2 vector B\n"
+              << "27.3 48.1 0.19  # 3 vector C (costs)\n"
+              << '\n'
+              << "Format 2, the non zero coefficients in any order:\n"
+              << "2               # model index\n"
+              << "2 3             # constraints and variables numbers\n"
+              << "3               # number of coefficients\n"
+              << "1 2 1           # row column coefficient\n"
+              << "0 0 1\n"
+              << "1 1 1\n"
+              << "1 1             # 2 vector B\n"
+              << "27.3 48.1 0.19  # 3 vector C (costs)\n"
               << std::endl;
 }
 
+bool
+has_extension(const std::string &filename, const char *extension)
+{
+    const std::size_t length = std::strlen(extension);
+
+    return filename.size() > length and
+        filename.compare(filename.size() - length, length, extension) == 0;
+}
+
+/// Print the result @e r of a model of @e m constraints and @e n variables
+/// and its costs @e c.
+void
+print(const mitm::result &r, mitm::index m, mitm::index n,
+      const mitm::real *c)
+{
+    if (r.status == mitm::result_status::success)
+        std::cout << "solution found in " << r.loop << " loops\n";
+    else
+        std::cout << (r.status == mitm::result_status::time_limit ?
+                      "time limit reached" : "no solution found")
+                  << ", best assignment found in "
+                  << r.loop << " loops violates " << r.violated
+                  << " constraints\n";
+    std::cout << "value: " << r.value << '\n';
+
+    // m / 2 values per line, at least one for the models of one constraint.
+    const mitm::index line = std::max<mitm::index>(1, m / 2);
+
+    for (mitm::index i = 0; i != n; ++i) {
+        std::cout << r.x[i] << ' ';
+        if ((i + 1) % line == 0)
+            std::cout << '\n';
+    }
+    std::cout << '\n';
+
+    for (mitm::index i = 0; i != n; ++i) {
+        std::cout << c[i] << ' ';
+        if ((i + 1) % line == 0)
+            std::cout << '\n';
+    }
+}
+
 }
 
 int
@@ -68,10 +135,14 @@ main(int argc, char *argv[])
     float kappa = 0.001;
     float delta = 0.0001;
     float theta = 0.001;
+    float time_limit = 0;
+    mitm::schedule policy = mitm::schedule::constant;
+    mitm::sweep order = mitm::sweep::all;
+    bool verify = true;
     int option;
     char *c;
 
-    while ((option = ::getopt(argc, argv, "l:k:d:t:m:h")) != -1) {
+    while ((option = ::getopt(argc, argv, "l:T:k:d:t:s:o:um:h")) != -1) {
         switch (option) {
         case 'l':
             errno = 0;
@@ -86,6 +157,22 @@ main(int argc, char *argv[])
                           << ::optarg << " for parameter l\n";
                 exit(EXIT_FAILURE);
             }
+            break;
+
+        case 'T':
+            errno = 0;
+            time_limit = std::strtof(::optarg, &c);
+
+            if ((errno == ERANGE && (time_limit == HUGE_VALF ||
+                                     time_limit == -HUGE_VALF))
+                || (errno != 0 && time_limit == 0)
+                || (c == ::optarg)
+                || (time_limit < 0)) {
+                std::cerr << "fail to convert parameter `"
+                          << ::optarg << " for parameter time limit (or T)\n";
+                exit(EXIT_FAILURE);
+            }
+            break;
 
         case 'k':
             errno = 0;
@@ -101,6 +188,7 @@ main(int argc, char *argv[])
                           << ::optarg << " for parameter kappa (or k)\n";
                 exit(EXIT_FAILURE);
             }
+            break;
 
         case 'd':
             errno = 0;
@@ -115,20 +203,54 @@ main(int argc, char *argv[])
                           << ::optarg << " for parameter delta (or l)\n";
                 exit(EXIT_FAILURE);
             }
+            break;
 
         case 't':
             errno = 0;
             theta = std::strtof(::optarg, &c);
 
-            if ((errno == ERANGE && (delta == HUGE_VALF ||
-                                     delta == -HUGE_VALF))
-                || (errno != 0 && delta == 0)
+            if ((errno == ERANGE && (theta == HUGE_VALF ||
+                                     theta == -HUGE_VALF))
+                || (errno != 0 && theta == 0)
                 || (c == ::optarg)
                 || (theta < 0 || theta > 1)) {
                 std::cerr << "fail to convert parameter `"
                           << ::optarg << " for parameter theta\n";
                 exit(EXIT_FAILURE);
             }
+            break;
+
+        case 's':
+            if (std::strcmp(::optarg, "constant") == 0)
+                policy = mitm::schedule::constant;
+            else if (std::strcmp(::optarg, "geometric") == 0)
+                policy = mitm::schedule::geometric;
+            else if (std::strcmp(::optarg, "violation") == 0)
+                policy = mitm::schedule::violation;
+            else if (std::strcmp(::optarg, "annealing") == 0)
+                policy = mitm::schedule::annealing;
+            else {
+                std::cerr << "unknown schedule `" << ::optarg << "'\n";
+                exit(EXIT_FAILURE);
+            }
+            break;
+
+        case 'o':
+            if (std::strcmp(::optarg, "all") == 0)
+                order = mitm::sweep::all;
+            else if (std::strcmp(::optarg, "worklist") == 0)
+                order = mitm::sweep::worklist;
+            else if (std::strcmp(::optarg, "violation") == 0)
+                order = mitm::sweep::violation;
+            else {
+                std::cerr << "unknown order `" << ::optarg << "'\n";
+                exit(EXIT_FAILURE);
+            }
+            break;
+
+        case 'u':
+            verify = false;
+            break;
 
         case 'm':
             option_method = ::optarg;
@@ -141,42 +263,44 @@ main(int argc, char *argv[])
     }
 
     for (int i = ::optind; i < argc; ++i) {
-        std::ifstream ifs(argv[i]);
-
-        if (not ifs.is_open()) {
-            std::cerr << "fail to open '" << argv[i] << "'\n";
-            continue;
-        }
-
         try {
-            mitm::SimpleState state;
-            ifs >> state;
+            mitm::options opts(option_limit,
+                               mitm::parameters(kappa, delta, theta, policy,
+                                                0.1, 0.9, order),
+                               option_method);
 
-            if (ifs.fail()) {
-                std::cerr << "/!\\ fail: to read SimpleState\n";
-                continue;
-            }
+            if (time_limit > 0)
+                opts.time_limit(std::chrono::duration<float>(time_limit));
 
-            mitm::result r = mitm::heuristic_algorithm(state, option_limit,
-                                                       delta, kappa, theta,
-                                                       std::string{});
-            std::cout << "solution found in " << r.loop << " loops\n";
-            for (mitm::index i = 0; i != state.variables(); ++i) {
-                std::cout << r.x[i] << ' ';
-                if ((i + 1) % (state.constraints() / 2) == 0)
-                    std::cout << '\n';
-            }
-            std::cout << '\n';
+            if (option_method == "gpgpu") {
+                mitm::SimpleState state;
+                mitm::load(argv[i], state);
+                ::print(mitm::heuristic_algorithm(state, opts),
+                        state.constraints(), state.variables(),
+                        state.c.data());
+            } else if (mitm::is_binary_model(argv[i])) {
+                mitm::MappedState state(argv[i]);
+                if (verify and not state.verify())
+                    throw mitm::io_error("binary model checksum mismatch", 0);
 
-            for (mitm::index i = 0; i != state.variables(); ++i) {
-                std::cout << state.c[i] << ' ';
-                if ((i + 1) % (state.constraints() / 2) == 0)
-                    std::cout << '\n';
+                ::print(mitm::heuristic_algorithm(state.view(), opts),
+                        state.constraints(), state.variables(),
+                        state.view().c);
+            } else {
+                mitm::SparseState state;
+                if (::has_extension(argv[i], ".mps"))
+                    mitm::load_mps(argv[i], state);
+                else if (::has_extension(argv[i], ".lp"))
+                    mitm::load_lp(argv[i], state);
+                else
+                    mitm::load(argv[i], state);
+                ::print(mitm::heuristic_algorithm(state, opts),
+                        state.constraints(), state.variables(),
+                        state.c.data());
             }
-
-
         } catch (const std::exception &e) {
-            std::cerr << "/!\\ fail: " << e.what() << '\n';
+            std::cerr << "/!\\ fail: " << argv[i] << ": " << e.what()
+                      << '\n';
         }
     }
 
@@ -0,0 +1,120 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_MAPPED_FILE_HPP
+#define FR_INRA_MITM_MAPPED_FILE_HPP
+
+#include <mitm/mitm.hpp>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mitm {
+
+/** mapped_file maps a file read-only in memory for the lifetime of the
+ * object. A file which cannot be mapped (a pipe, a terminal) is read in an
+ * owned buffer instead.
+ *
+ * @code
+ * mitm::mapped_file file("model.txt");
+ * std::count(file.data(), file.data() + file.size(), '\n');
+ * @endcode
+ */
+class mapped_file
+{
+    const char *m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    std::vector<char> m_buffer;
+
+public:
+    /// Throws io_error if the file cannot be opened or read.
+    explicit mapped_file(const char *filename);
+    ~mapped_file() noexcept;
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    const char* data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+};
+
+inline
+mapped_file::mapped_file(const char *filename)
+    : m_data(nullptr)
+    , m_size(0)
+    , m_mapped(false)
+{
+    const int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        throw io_error("fail to open file", 0);
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+        void *ptr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                           PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (ptr != MAP_FAILED) {
+            ::madvise(ptr, static_cast<std::size_t>(st.st_size),
+                      MADV_SEQUENTIAL);
+
+            m_data = static_cast<const char*>(ptr);
+            m_size = static_cast<std::size_t>(st.st_size);
+            m_mapped = true;
+            ::close(fd);
+            return;
+        }
+    }
+
+    char chunk[65536];
+    ssize_t read;
+    while ((read = ::read(fd, chunk, sizeof(chunk))) > 0)
+        m_buffer.insert(m_buffer.end(), chunk, chunk + read);
+
+    ::close(fd);
+
+    if (read < 0)
+        throw io_error("fail to read file", 0);
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+}
+
+inline
+mapped_file::~mapped_file() noexcept
+{
+    if (m_mapped)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+}
+
+#endif
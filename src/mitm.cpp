@@ -21,26 +21,65 @@
  */
 
 #include <mitm/mitm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 #include "cstream.hpp"
 #include "internal.hpp"
+#include "assert.hpp"
 
 namespace mitm {
 
+namespace {
+
+/// The classic engine selected by @e o.impl on the model @e view.
+template <typename Index>
+mitm::result
+heuristic_algorithm_csr(const basic_csr_view<Index> &view, const options &o)
+{
+    if (o.impl == "parallel")
+        return heuristic_algorithm_parallel<real, Index>(view, o);
+
+    if (o.impl == "portfolio")
+        return heuristic_algorithm_portfolio<real, Index>(view, o);
+
+    Expects(o.impl != "gpgpu",
+            "heuristic_algorithm: gpgpu needs a dense SimpleState");
+
+    return heuristic_algorithm_default<real, Index>(view, o);
+}
+
+/// Copy of @e value in [0..bound], -1 otherwise: the checks of the engine
+/// reject the bad arrays before and after the conversion.
+inline std::int32_t
+narrow(index value, index bound) noexcept
+{
+    return value >= 0 and value <= bound ?
+        static_cast<std::int32_t>(value) : -1;
+}
+
+}
+
 #ifndef MITM_HAVE_CUDA
 mitm::result
-heuristic_algorithm_gpgu(const SimpleState&s, index limit, mitm::real kappa,
-                         mitm::real delta, mitm::real theta)
+heuristic_algorithm_gpgu(const SimpleState&s, const options &o)
 {
-    (void)s;
-    (void)limit;
-    (void)kappa;
-    (void)delta;
-    (void)theta;
+    (void)o;
 
     out() << "heuristic_algorithm_gpgu is unavailable. "
         "Install cuda package and rerun CMake\n";
 
-    return mitm::result{};
+    // The assignment x = 0, its cost is 0 and it violates the rows of
+    // b != 0.
+    mitm::result ret;
+    ret.x.assign(s.c.size(), false);
+    ret.loop = 0;
+    ret.value = 0;
+    ret.violated = static_cast<index>(
+        std::count_if(s.b.cbegin(), s.b.cend(),
+                      [](int bk) { return bk != 0; }));
+    ret.status = result_status::limit_reached;
+    return ret;
 }
 #endif
 
@@ -49,16 +88,192 @@ heuristic_algorithm(const SimpleState &s, index limit,
                     mitm::real kappa, mitm::real delta, mitm::real theta,
                     const std::string &impl)
 {
-    cstream cs(1);
+    return heuristic_algorithm(s, limit, parameters(kappa, delta, theta),
+                               impl);
+}
+
+mitm::result
+heuristic_algorithm(const SimpleState &s, index limit, const parameters &p,
+                    const std::string &impl)
+{
+    return heuristic_algorithm(s, options(limit, p, impl));
+}
+
+template <typename Real, typename Index>
+mitm::result
+heuristic_algorithm(const SimpleState &s, const options &o)
+{
+    Expects(o.progress_every > 0,
+            "heuristic_algorithm: progress_every must be [1..+oo[");
 
-    if (not impl.empty())
+    flush_guard flush(out());
+
+    if (not o.impl.empty())
         out().printf("heuristic_algorithm using the `%s' implementation\n",
-                     impl.c_str());
+                     o.impl.c_str());
+
+    if (o.impl == "gpgpu")
+        return heuristic_algorithm_gpgu(s, o);
+
+    if (o.impl == "parallel")
+        return heuristic_algorithm_parallel<Real, Index>(s, o);
+
+    if (o.impl == "portfolio")
+        return heuristic_algorithm_portfolio<Real, Index>(s, o);
+
+    return heuristic_algorithm_default<Real, Index>(s, o);
+}
+
+template mitm::result
+heuristic_algorithm<float, std::int32_t>(const SimpleState&, const options&);
+template mitm::result
+heuristic_algorithm<float, std::int64_t>(const SimpleState&, const options&);
+template mitm::result
+heuristic_algorithm<double, std::int32_t>(const SimpleState&,
+                                          const options&);
+template mitm::result
+heuristic_algorithm<double, std::int64_t>(const SimpleState&,
+                                          const options&);
+
+mitm::result
+heuristic_algorithm(const SimpleState &s, const options &o)
+{
+    if (is_int32_addressable(s))
+        return heuristic_algorithm<real, std::int32_t>(s, o);
+
+    return heuristic_algorithm<real, std::int64_t>(s, o);
+}
+
+mitm::result
+heuristic_algorithm(const csr_view &view, const options &o)
+{
+    Expects(o.progress_every > 0,
+            "heuristic_algorithm: progress_every must be [1..+oo[");
+    Expects(is_ones(view),
+            "heuristic_algorithm: coefficients must be 1 without bounds");
+
+    flush_guard flush(out());
+
+    if (not o.impl.empty())
+        out().printf("heuristic_algorithm using the `%s' implementation\n",
+                     o.impl.c_str());
+
+    if (not is_int32_addressable(view))
+        return heuristic_algorithm_csr(view, o);
+
+    // The std::int32_t positions halve the column and position arrays
+    // the engine builds, the CSR arrays of the view are copied once.
+    const index nonzeros = view.rows_ptr[view.rows];
+    std::vector<std::int32_t> rows_ptr(view.rows + 1);
+    std::vector<std::int32_t> cols_index(nonzeros);
+
+    for (index k = 0; k <= view.rows; ++k)
+        rows_ptr[k] = narrow(view.rows_ptr[k], nonzeros);
 
-    if (impl == "gpgpu")
-        return heuristic_algorithm_gpgu(s, limit, kappa, delta, theta);
+    if (view.cols_index)
+        for (index pos = 0; pos != nonzeros; ++pos)
+            cols_index[pos] = narrow(view.cols_index[pos], view.cols - 1);
+
+    const basic_csr_view<std::int32_t> narrowed {
+        static_cast<std::int32_t>(view.rows),
+        static_cast<std::int32_t>(view.cols),
+        rows_ptr.data(), view.cols_index ? cols_index.data() : nullptr,
+        view.values, view.b, view.c };
+
+    return heuristic_algorithm_csr(narrowed, o);
+}
+
+mitm::result
+heuristic_algorithm(const SparseState &s, const options &o)
+{
+    Expects(s.constraints() > 0 and s.variables() > 0 and
+            s.rows_ptr.size() == s.b.size() + 1,
+            "heuristic_algorithm: sparse state not initialized");
+
+    if (not s.bounds.empty()) {
+        Expects(o.progress_every > 0,
+                "heuristic_algorithm: progress_every must be [1..+oo[");
+
+        flush_guard flush(out());
+
+        if (not o.impl.empty())
+            out().printf("heuristic_algorithm using the `%s' "
+                         "implementation\n", o.impl.c_str());
+
+        return heuristic_algorithm_default(s, o);
+    }
+
+    return heuristic_algorithm(s.view(), o);
+}
+
+std::future<mitm::result>
+heuristic_algorithm_async(const SimpleState &s, const options &o)
+{
+    // The state and the options are copied into the task, the caller may
+    // release its own before the end of the run. The token is shared.
+    return std::async(std::launch::async,
+                      [](SimpleState state, options opt)
+                      {
+                          return heuristic_algorithm(state, opt);
+                      }, s, o);
+}
+
+mitm::result
+heuristic_algorithm(const SimpleState &s, index limit,
+                    const std::vector<parameters> &portfolio,
+                    unsigned thread_number, bool first_solution)
+{
+    return heuristic_algorithm(s, options(limit), portfolio, thread_number,
+                               first_solution);
+}
+
+mitm::result
+heuristic_algorithm(const SimpleState &s, const options &o,
+                    const std::vector<parameters> &portfolio,
+                    unsigned thread_number, bool first_solution)
+{
+    Expects(o.progress_every > 0,
+            "heuristic_algorithm: progress_every must be [1..+oo[");
+
+    flush_guard flush(out());
+
+    if (is_int32_addressable(s))
+        return heuristic_algorithm_portfolio<real, std::int32_t>(
+            s, o, portfolio, thread_number, first_solution);
+
+    return heuristic_algorithm_portfolio<real, std::int64_t>(
+        s, o, portfolio, thread_number, first_solution);
+}
+
+mitm::result
+heuristic_algorithm(const NegativeCoefficient& s, index limit,
+                    mitm::real kappa, mitm::real delta, mitm::real theta,
+                    const std::string &impl)
+{
+    return heuristic_algorithm(s, limit, parameters(kappa, delta, theta),
+                               impl);
+}
+
+mitm::result
+heuristic_algorithm(const NegativeCoefficient& s, index limit,
+                    const parameters &p, const std::string &impl)
+{
+    return heuristic_algorithm(s, options(limit, p, impl));
+}
+
+mitm::result
+heuristic_algorithm(const NegativeCoefficient& s, const options &o)
+{
+    Expects(o.progress_every > 0,
+            "heuristic_algorithm: progress_every must be [1..+oo[");
+
+    flush_guard flush(out());
+
+    if (not o.impl.empty())
+        out().printf("heuristic_algorithm using the `%s' implementation\n",
+                     o.impl.c_str());
 
-    return heuristic_algorithm_default(s, limit, kappa, delta, theta);
+    return heuristic_algorithm_default(s, o);
 }
 
 }
@@ -53,6 +53,12 @@
 #define MITM_MODULE MITM_HELPER_DLL_EXPORT
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
 #include <stdexcept>
 #include <istream>
 #include <ostream>
@@ -76,7 +82,7 @@ private:
 };
 
 #ifdef MITM_REAL_TYPE
-typedef MITM_REAL_TYPE real
+typedef MITM_REAL_TYPE real;
 #else
 typedef float real;
 #endif
@@ -118,7 +124,7 @@ public:
             os << "A:\n";
             for (index i = 0; i != m; ++i) {
                 for (index j = 0; j != n; ++j)
-                    os << s.a[i * m + j] << ' ';
+                    os << s.a[i * n + j] << ' ';
 
                 os << '\n';
             }
@@ -132,6 +138,8 @@ public:
             for (index i = 0; i != n; ++i)
                 os << s.c[i] << ' ';
             os << '\n';
+
+            return os;
         }
 };
 
@@ -169,6 +177,60 @@ public:
     std::vector<real> c;
 };
 
+/// How kappa and theta change between two loops of the Wedelin heuristic.
+enum class schedule
+{
+    constant,   ///< kappa and theta never change.
+    geometric,  ///< kappa grows by a factor (1 + rate) per loop.
+    violation,  ///< kappa grows with the ratio of violated constraints.
+    annealing   ///< theta moves toward 1 by a factor rate per loop.
+};
+
+/// The constraints updated by a loop of the Wedelin heuristic.
+enum class sweep
+{
+    all,        ///< every violated constraint, in index order.
+    worklist,   ///< only the violated constraints and the constraints
+                ///< which become violated during the loop.
+    violation   ///< as worklist, the most violated constraints first.
+};
+
+/// The parameters of the Wedelin heuristic.
+struct parameters
+{
+    parameters(real kappa_ = 0.001, real delta_ = 0.0001,
+               real theta_ = 0.001, schedule policy_ = schedule::constant,
+               real rate_ = 0.1, real kappa_max_ = 0.9,
+               sweep order_ = sweep::all)
+        : kappa(kappa_)
+        , delta(delta_)
+        , theta(theta_)
+        , policy(policy_)
+        , rate(rate_)
+        , kappa_max(kappa_max_)
+        , order(order_)
+    {}
+
+    real kappa;       ///< [0..1[
+    real delta;       ///< [0..+oo[
+    real theta;       ///< [0..1]
+    schedule policy;  ///< update of kappa and theta after each loop.
+    real rate;        ///< speed of the schedule ]0..1].
+    real kappa_max;   ///< kappa upper bound of the schedules [0..1[, raised
+                      ///< to kappa when below.
+    sweep order;      ///< constraints visited by a loop.
+};
+
+/// The state of the solution vector of a result.
+enum class result_status
+{
+    success,        ///< x satisfies all the constraints.
+    limit_reached,  ///< no solution found in the limit, x is the least
+                    ///< violated assignment seen (the cheapest on ties).
+    time_limit,     ///< the deadline is over, x as limit_reached.
+    cancelled       ///< the cancellation token was set, x as limit_reached.
+};
+
 struct result
 {
     /// The solution vector.
@@ -176,20 +238,389 @@ struct result
 
     /// Number of loop necessary.
     index loop;
+
+    /// The cost c x of the solution vector.
+    real value;
+
+    /// Number of constraints violated by the solution vector.
+    index violated;
+
+    result_status status;
+};
+
+/// A result without the solution vector, the solver writes it in a
+/// buffer of the caller.
+struct result_summary
+{
+    index loop;             ///< Number of loop necessary.
+    real value;             ///< The cost c x of the solution vector.
+    index violated;         ///< Number of constraints violated by x.
+    result_status status;
+};
+
+/** basic_csr_view describes a model stored by the caller: the constraints
+ * matrix A in compressed rows (CSR), b and c. The solver reads A in place,
+ * the arrays must remain valid during the solve() call.
+ */
+template <typename Index>
+struct basic_csr_view
+{
+    Index rows;               ///< m, the number of constraints.
+    Index cols;               ///< n, the number of variables.
+    const Index *rows_ptr;    ///< m + 1 positions, rows_ptr[0] = 0.
+    const Index *cols_index;  ///< the column of each coefficient,
+                              ///< distinct in a row.
+    const int *values;        ///< the coefficients or nullptr if all
+                              ///< are 1, the solvers only accept 1.
+    const int *b;             ///< the m right hand sides.
+    const real *c;            ///< the n costs.
+};
+
+using csr_view = basic_csr_view<index>;
+
+/** A SparseState stores the constraints matrix A in compressed rows, as
+ * read from the sparse text formats, without the m x n dense matrix of
+ * SimpleState.
+ */
+class MITM_API SparseState
+{
+public:
+    /** Try to initialize an empty matrix of @e m constraints and @e n
+     * variables, @e b and @e c.
+     *
+     * return 0 if success otherwise -EDOM if m and n are bad or -ENOMEM if
+     * not enough memory.
+     */
+    int init(index m, index n) noexcept;
+
+    index constraints() const noexcept;
+
+    index variables() const noexcept;
+
+    index nonzeros() const noexcept;
+
+    /// A view on the arrays, valid until the next change of the state.
+    csr_view view() const noexcept;
+
+    std::vector<index> rows_ptr;    ///< m + 1 positions.
+    std::vector<index> cols_index;  ///< the column of each coefficient.
+    std::vector<int> values;        ///< the coefficients, empty if all 1.
+                                    ///< Other values need bounds.
+    std::vector<int> b;
+
+    /// The bounds of the constraints, empty if the constraints are the
+    /// equalities of b. With bounds, b is unused and the model is solved
+    /// by the heuristic for negative coefficients.
+    std::vector<NegativeCoefficient::b_bounds> bounds;
+
+    std::vector<real> c;
+
+    std::size_t size() const noexcept
+    {
+        return rows_ptr.size() * sizeof(index)
+            + cols_index.size() * sizeof(index)
+            + values.size() * sizeof(int)
+            + b.size() * sizeof(int)
+            + bounds.size() * sizeof(NegativeCoefficient::b_bounds)
+            + c.size() * sizeof(real);
+    }
+};
+
+/** A cancellation_token stops a running heuristic from another thread.
+ * Copies share the same flag.
+ */
+class cancellation_token
+{
+public:
+    cancellation_token()
+        : m_flag(std::make_shared<std::atomic<bool>>(false))
+    {}
+
+    void cancel() noexcept
+    {
+        m_flag->store(true, std::memory_order_relaxed);
+    }
+
+    bool is_cancelled() const noexcept
+    {
+        return m_flag->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+/// Callback called with the loop, the number of violated constraints and
+/// the cost c x of the current assignment.
+using progress_function = std::function<void(index, index, real)>;
+
+/// The options of a heuristic_algorithm run.
+struct options
+{
+    using clock = std::chrono::steady_clock;
+
+    options(index limit_ = 1000, const parameters &p_ = parameters(),
+            const std::string &impl_ = std::string())
+        : limit(limit_)
+        , p(p_)
+        , impl(impl_)
+        , deadline(clock::time_point::max())
+        , progress_every(1)
+    {}
+
+    /// Stop the run @e duration after now.
+    template <typename Rep, typename Period>
+    void time_limit(const std::chrono::duration<Rep, Period> &duration)
+    {
+        deadline = clock::now() +
+            std::chrono::duration_cast<clock::duration>(duration);
+    }
+
+    index limit;                ///< maximum number of loops.
+    parameters p;               ///< the parameters of the heuristic.
+    std::string impl;           ///< classic, parallel, portfolio or gpgpu.
+    clock::time_point deadline; ///< the run stops after this time point.
+    cancellation_token token;   ///< the run stops when the token is set.
+    progress_function progress; ///< called every progress_every loops.
+    index progress_every;       ///< [1..+oo[
 };
 
 MITM_API std::istream &operator>>(std::istream &is, SimpleState &s);
 
+/** Read the model of the text file @e filename, in the format of the
+ * stream operator. The file is mapped in memory and the numbers are
+ * converted in place, which is much faster than the stream operator on
+ * large models. Throws io_error with the line of the error.
+ */
+MITM_API void load(const std::string &filename, SimpleState &s);
+
+/** Read the model of the text file @e filename in a SparseState. The
+ * first number of the file selects the format:
+ * - 0, the dense format of the stream operator;
+ * - 1, for each constraint the number of its variables then their
+ *   columns (0-based), all the coefficients are 1;
+ * - 2, the number of coefficients then the `row column coefficient'
+ *   triplets (0-based) in any order.
+ * The @e b and @e c vectors follow the matrix. The sparse formats never
+ * build the dense matrix. Throws io_error with the line of the error.
+ */
+MITM_API void load(const std::string &filename, SparseState &s);
+
+/** Read the MPS file @e filename (free format: the names are separated by
+ * spaces) in a SparseState, in a single pass over the mapped file. The
+ * first N row is the objective, the other N rows are ignored. The E rows
+ * with an integer right hand side become b when no coefficient is
+ * negative, otherwise every row gets its bounds, with the RANGES. The
+ * coefficients must be integers and the variables binary: the BOUNDS
+ * section accepts only BV, UP 1 and LO 0. An OBJSENSE MAX negates the
+ * costs. Throws io_error with the line of the error.
+ */
+MITM_API void load_mps(const std::string &filename, SparseState &s);
+
+/** Read the CPLEX LP file @e filename in a SparseState, as load_mps().
+ * The sections Minimize or Maximize, Subject To, Bounds, Binary and End
+ * are read, the variables are numbered in the order of their first use.
+ */
+MITM_API void load_lp(const std::string &filename, SparseState &s);
+
+/** Write @e s in the binary model format: a versioned header then the
+ * CSR arrays, b and c, each aligned on 64 bytes, and a checksum of the
+ * arrays. Throws io_error if the file cannot be written.
+ */
+MITM_API void save(const std::string &filename, const SparseState &s);
+
+/// Returns true if @e filename starts as a binary model file.
+MITM_API bool is_binary_model(const std::string &filename);
+
+/** A MappedState maps a binary model file written by save() in memory.
+ * The arrays are used in place by the heuristic: opening a model costs a
+ * header check whatever its size. Throws io_error if the file is not a
+ * binary model of this version, of these index and real types, or if it
+ * is truncated. The constructor does not read the arrays: a file
+ * corrupted after save() is only detected by verify(), a pass over the
+ * whole file, which the caller must run before trusting the model (mitm
+ * does unless -u is given).
+ *
+ * @code
+ * mitm::MappedState model("model.mitm");
+ * if (not model.verify())
+ *     throw std::runtime_error("corrupted model");
+ *
+ * auto r = mitm::heuristic_algorithm(model.view(), mitm::options());
+ * @endcode
+ */
+class MITM_API MappedState
+{
+public:
+    explicit MappedState(const std::string &filename);
+    ~MappedState();
+
+    MappedState(MappedState&&) noexcept;
+    MappedState& operator=(MappedState&&) noexcept;
+
+    index constraints() const noexcept;
+    index variables() const noexcept;
+    index nonzeros() const noexcept;
+
+    /// A view on the mapped arrays, valid during the life of the object.
+    csr_view view() const noexcept;
+
+    /// Computes the checksum of the arrays and compares it to the header.
+    bool verify() const noexcept;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> m_impl;
+};
+
+/** Run the heuristic selected by @e o.impl. The best assignment found is
+ * returned when @e o.limit, @e o.deadline or @e o.token stops the run.
+ */
+MITM_API result
+heuristic_algorithm(const SimpleState &s, const options &o);
+
+/** As above with @e Real reduced costs and @e Index positions in the
+ * solver core. @e Real is float or double, @e Index is std::int32_t or
+ * std::int64_t. The overload without template arguments uses real and
+ * std::int32_t if it can address all the coefficients of A, otherwise
+ * std::int64_t.
+ */
+template <typename Real, typename Index>
+MITM_API result
+heuristic_algorithm(const SimpleState &s, const options &o);
+
+extern template result
+heuristic_algorithm<float, std::int32_t>(const SimpleState&, const options&);
+extern template result
+heuristic_algorithm<float, std::int64_t>(const SimpleState&, const options&);
+extern template result
+heuristic_algorithm<double, std::int32_t>(const SimpleState&,
+                                          const options&);
+extern template result
+heuristic_algorithm<double, std::int64_t>(const SimpleState&,
+                                          const options&);
+
+/** Run the heuristic selected by @e o.impl (classic, parallel or
+ * portfolio) on the compressed rows of @e model. The arrays are read in
+ * place, only b and c are copied.
+ */
+MITM_API result
+heuristic_algorithm(const csr_view &model, const options &o);
+
+/// As above on the compressed rows of @e s. With bounds, @e o.impl is
+/// ignored and the heuristic for negative coefficients is used.
+MITM_API result
+heuristic_algorithm(const SparseState &s, const options &o);
+
+/** Run the heuristic in a new thread on a copy of @e s. Use the token of
+ * @e o to stop it.
+ */
+MITM_API std::future<result>
+heuristic_algorithm_async(const SimpleState &s, const options &o);
+
+/** A solver keeps the buffers of the classic heuristic between two
+ * solve() calls. A model with as many or fewer constraints, variables and
+ * non zero coefficients than the previous ones is solved without
+ * allocation, except the vector of the result.
+ *
+ * @code
+ * mitm::solver solver;
+ * for (const auto& model : models)
+ *     results.emplace_back(solver.solve(model, o));
+ * @endcode
+ */
+class MITM_API solver
+{
+public:
+    solver();
+    ~solver();
+
+    solver(solver&&) noexcept;
+    solver& operator=(solver&&) noexcept;
+
+    /** Run the classic heuristic on @e s, as heuristic_algorithm() without
+     * the output on the console. @e o.impl is ignored.
+     */
+    result solve(const SimpleState &s, const options &o);
+
+    /** Run the classic heuristic on the model of the caller @e model and
+     * write the solution in @e x, an array of model.cols bytes set to 0 or
+     * 1. Only b and c are copied, in the working vectors of the heuristic.
+     * @e Index is std::int32_t or std::int64_t. The coefficients must be
+     * 1: a row selects b_k variables.
+     */
+    template <typename Index>
+    result_summary solve(const basic_csr_view<Index> &model,
+                         const options &o, std::uint8_t *x);
+
+    /// As above, @e columns is replaced by the increasing list of the
+    /// variables set to 1.
+    template <typename Index>
+    result_summary solve(const basic_csr_view<Index> &model,
+                         const options &o, std::vector<Index> &columns);
+
+    /// Memory used by the buffers in bytes.
+    std::size_t size() const noexcept;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> m_impl;
+};
+
+extern template result_summary
+solver::solve<std::int32_t>(const basic_csr_view<std::int32_t>&,
+                            const options&, std::uint8_t*);
+extern template result_summary
+solver::solve<std::int64_t>(const basic_csr_view<std::int64_t>&,
+                            const options&, std::uint8_t*);
+extern template result_summary
+solver::solve<std::int32_t>(const basic_csr_view<std::int32_t>&,
+                            const options&, std::vector<std::int32_t>&);
+extern template result_summary
+solver::solve<std::int64_t>(const basic_csr_view<std::int64_t>&,
+                            const options&, std::vector<std::int64_t>&);
+
 MITM_API result
 heuristic_algorithm(const SimpleState &s, index limit,
                     real kappa, real delta, real theta,
                     const std::string &impl);
 
+MITM_API result
+heuristic_algorithm(const SimpleState &s, index limit, const parameters &p,
+                    const std::string &impl);
+
+/** Run one heuristic per parameter set of @e portfolio, each with a
+ * different constraints order, on @e thread_number threads.
+ *
+ * If @e first_solution is true, the first solution found stops the other
+ * instances and is returned, otherwise all instances run until they find a
+ * solution or reach @e limit loops and the solution with the lowest cost
+ * is returned.
+ */
+MITM_API result
+heuristic_algorithm(const SimpleState &s, index limit,
+                    const std::vector<parameters> &portfolio,
+                    unsigned thread_number, bool first_solution = true);
+
+/// As above, the limit, the deadline and the token of @e o apply to all
+/// the instances, the progress callback follows the first one.
+MITM_API result
+heuristic_algorithm(const SimpleState &s, const options &o,
+                    const std::vector<parameters> &portfolio,
+                    unsigned thread_number, bool first_solution = true);
+
 MITM_API result
 heuristic_algorithm(const NegativeCoefficient& s, index limit,
                     real kappa, real delta, real theta,
                     const std::string &impl);
 
+MITM_API result
+heuristic_algorithm(const NegativeCoefficient& s, index limit,
+                    const parameters &p, const std::string &impl);
+
+MITM_API result
+heuristic_algorithm(const NegativeCoefficient& s, const options &o);
+
 
 inline int
 SimpleState::init(index m, index n) noexcept
@@ -223,6 +654,59 @@ SimpleState::variables() const noexcept
     return static_cast<index>(c.size());
 }
 
+inline int
+SparseState::init(index m, index n) noexcept
+{
+    if (m <= 0 or n <= 0)
+        return -EDOM;
+
+    try {
+        rows_ptr.assign(m + 1, 0);
+        cols_index.clear();
+        values.clear();
+        b.resize(m);
+        bounds.clear();
+        c.resize(n);
+    } catch(const std::bad_alloc& e) {
+        std::vector<index>().swap(rows_ptr);
+        std::vector<index>().swap(cols_index);
+        std::vector<int>().swap(values);
+        std::vector<int>().swap(b);
+        std::vector<NegativeCoefficient::b_bounds>().swap(bounds);
+        std::vector<real>().swap(c);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+inline index
+SparseState::constraints() const noexcept
+{
+    return static_cast<index>(b.size());
+}
+
+inline index
+SparseState::variables() const noexcept
+{
+    return static_cast<index>(c.size());
+}
+
+inline index
+SparseState::nonzeros() const noexcept
+{
+    return static_cast<index>(cols_index.size());
+}
+
+inline csr_view
+SparseState::view() const noexcept
+{
+    return csr_view { constraints(), variables(),
+                      rows_ptr.data(), cols_index.data(),
+                      values.empty() ? nullptr : values.data(),
+                      b.data(), c.data() };
+}
+
 }
 
 #endif
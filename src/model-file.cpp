@@ -0,0 +1,325 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <mitm/mitm.hpp>
+#include "mapped-file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace {
+
+/** The binary model file: a header of 64 bytes then the sections
+ * rows_ptr, cols_index, values (if any), b and c, each starting on a
+ * multiple of 64 bytes, padded with zeros. The integers are written in
+ * the byte order of the host, @e endian detects another one.
+ */
+struct header
+{
+    char magic[8];              ///< "MITMBIN" and a null byte.
+    std::uint32_t version;
+    std::uint32_t endian;       ///< 0x01020304.
+    std::uint32_t index_size;   ///< bytes of a mitm::index position.
+    std::uint32_t real_size;    ///< bytes of a mitm::real cost.
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t nonzeros;
+    std::uint32_t flags;        ///< has_values if the values are stored.
+    std::uint32_t reserved;
+    std::uint64_t checksum;     ///< of the bytes after the header.
+};
+
+static_assert(sizeof(header) == 64, "the header is 64 bytes");
+
+const char model_magic[8] = { 'M', 'I', 'T', 'M', 'B', 'I', 'N', '\0' };
+const std::uint32_t model_version = 1;
+const std::uint32_t model_endian = 0x01020304;
+const std::uint32_t has_values = 1;
+const std::uint64_t alignment = 64;
+
+/// The sizes of the sections in bytes, before padding.
+struct layout
+{
+    std::uint64_t rows_ptr;
+    std::uint64_t cols_index;
+    std::uint64_t values;
+    std::uint64_t b;
+    std::uint64_t c;
+
+    explicit layout(const header &h) noexcept
+        : rows_ptr((h.rows + 1) * sizeof(mitm::index))
+        , cols_index(h.nonzeros * sizeof(mitm::index))
+        , values(h.flags & has_values ? h.nonzeros * sizeof(int) : 0)
+        , b(h.rows * sizeof(int))
+        , c(h.cols * sizeof(mitm::real))
+    {}
+
+    static std::uint64_t padded(std::uint64_t size) noexcept
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    std::uint64_t file_size() const noexcept
+    {
+        return sizeof(header) + padded(rows_ptr) + padded(cols_index) +
+            padded(values) + padded(b) + padded(c);
+    }
+};
+
+/** A 64-bit word by word FNV-1a: a change of a single word always
+ * changes the result and the loop runs at several GB/s, the checksum of
+ * a large model stays cheap next to its conversion.
+ */
+class checksum
+{
+    std::uint64_t m_hash;
+    unsigned char m_tail[8];
+    unsigned m_tail_size;
+
+    void mix(std::uint64_t word) noexcept
+    {
+        m_hash = (m_hash ^ word) * UINT64_C(0x100000001b3);
+    }
+
+public:
+    checksum() noexcept
+        : m_hash(UINT64_C(0xcbf29ce484222325))
+        , m_tail_size(0)
+    {}
+
+    void update(const void *data, std::size_t size) noexcept
+    {
+        const unsigned char *ptr = static_cast<const unsigned char*>(data);
+
+        while (size and m_tail_size) {
+            m_tail[m_tail_size++] = *ptr++;
+            --size;
+
+            if (m_tail_size == 8) {
+                std::uint64_t word;
+                std::memcpy(&word, m_tail, 8);
+                mix(word);
+                m_tail_size = 0;
+            }
+        }
+
+        for (; size >= 8; ptr += 8, size -= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, 8);
+            mix(word);
+        }
+
+        for (; size; --size)
+            m_tail[m_tail_size++] = *ptr++;
+    }
+
+    std::uint64_t value() const noexcept
+    {
+        std::uint64_t hash = m_hash;
+        for (unsigned i = 0; i != m_tail_size; ++i)
+            hash = (hash ^ m_tail[i]) * UINT64_C(0x100000001b3);
+
+        return hash;
+    }
+};
+
+/// Writes @e size bytes of @e data and the padding to the next multiple
+/// of the alignment, through the checksum.
+void write_section(std::ofstream &ofs, checksum &sum, const void *data,
+                   std::uint64_t size)
+{
+    static const char zeros[alignment] = {};
+
+    const std::uint64_t padding = layout::padded(size) - size;
+
+    ofs.write(static_cast<const char*>(data),
+              static_cast<std::streamsize>(size));
+    ofs.write(zeros, static_cast<std::streamsize>(padding));
+    sum.update(data, size);
+    sum.update(zeros, padding);
+}
+
+} // anonymous namespace
+
+namespace mitm {
+
+void save(const std::string &filename, const SparseState &s)
+{
+    if (s.constraints() <= 0 or s.variables() <= 0 or
+        s.rows_ptr.size() != s.b.size() + 1 or
+        static_cast<std::size_t>(s.rows_ptr.back()) != s.cols_index.size() or
+        (not s.values.empty() and s.values.size() != s.cols_index.size()))
+        throw io_error("sparse state not initialized", 0);
+
+    if (not s.bounds.empty())
+        throw io_error("binary model of bounded constraints unsupported", 0);
+
+    header h;
+    std::memcpy(h.magic, model_magic, sizeof(h.magic));
+    h.version = model_version;
+    h.endian = model_endian;
+    h.index_size = sizeof(index);
+    h.real_size = sizeof(real);
+    h.rows = static_cast<std::uint64_t>(s.constraints());
+    h.cols = static_cast<std::uint64_t>(s.variables());
+    h.nonzeros = static_cast<std::uint64_t>(s.nonzeros());
+    h.flags = s.values.empty() ? 0 : has_values;
+    h.reserved = 0;
+    h.checksum = 0;
+
+    const layout sizes(h);
+
+    std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+    if (not ofs)
+        throw io_error("fail to open file", 0);
+
+    // The header is written again with the checksum at the end.
+    ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    checksum sum;
+    ::write_section(ofs, sum, s.rows_ptr.data(), sizes.rows_ptr);
+    ::write_section(ofs, sum, s.cols_index.data(), sizes.cols_index);
+    if (h.flags & has_values)
+        ::write_section(ofs, sum, s.values.data(), sizes.values);
+    ::write_section(ofs, sum, s.b.data(), sizes.b);
+    ::write_section(ofs, sum, s.c.data(), sizes.c);
+
+    h.checksum = sum.value();
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    if (not ofs.flush())
+        throw io_error("fail to write file", 0);
+}
+
+bool is_binary_model(const std::string &filename)
+{
+    char magic[sizeof(model_magic)];
+
+    std::ifstream ifs(filename, std::ios::binary);
+    return ifs.read(magic, sizeof(magic)) and
+        std::memcmp(magic, model_magic, sizeof(magic)) == 0;
+}
+
+struct MappedState::impl
+{
+    explicit impl(const std::string &filename)
+        : file(filename.c_str())
+    {
+        if (file.size() < sizeof(header))
+            throw io_error("not a binary model file", 0);
+
+        std::memcpy(&h, file.data(), sizeof(h));
+
+        if (std::memcmp(h.magic, model_magic, sizeof(h.magic)) != 0)
+            throw io_error("not a binary model file", 0);
+
+        if (h.endian != model_endian)
+            throw io_error("binary model of another byte order", 0);
+
+        if (h.version != model_version)
+            throw io_error("unsupported binary model version", 0);
+
+        if (h.index_size != sizeof(index) or h.real_size != sizeof(real) or
+            h.reserved != 0)
+            throw io_error("binary model of other index or real types", 0);
+
+        const std::uint64_t max = std::numeric_limits<index>::max() / 8;
+        if (h.rows == 0 or h.cols == 0 or h.rows > max or h.cols > max or
+            h.nonzeros > max or (h.flags & ~has_values))
+            throw io_error("bad binary model header", 0);
+
+        const layout sizes(h);
+        if (sizes.file_size() != file.size())
+            throw io_error("truncated binary model file", 0);
+
+        // The sections start on multiples of 64 bytes of a mapping aligned
+        // on a page or of a buffer aligned for any scalar type.
+        const char *ptr = file.data() + sizeof(header);
+        rows_ptr = reinterpret_cast<const index*>(ptr);
+        ptr += layout::padded(sizes.rows_ptr);
+        cols_index = reinterpret_cast<const index*>(ptr);
+        ptr += layout::padded(sizes.cols_index);
+        values = sizes.values ? reinterpret_cast<const int*>(ptr) : nullptr;
+        ptr += layout::padded(sizes.values);
+        b = reinterpret_cast<const int*>(ptr);
+        ptr += layout::padded(sizes.b);
+        c = reinterpret_cast<const real*>(ptr);
+
+        if (rows_ptr[0] != 0 or
+            static_cast<std::uint64_t>(rows_ptr[h.rows]) != h.nonzeros)
+            throw io_error("bad binary model rows", 0);
+    }
+
+    mapped_file file;
+    header h;
+    const index *rows_ptr;
+    const index *cols_index;
+    const int *values;
+    const int *b;
+    const real *c;
+};
+
+MappedState::MappedState(const std::string &filename)
+    : m_impl(new impl(filename))
+{
+}
+
+MappedState::~MappedState() = default;
+
+MappedState::MappedState(MappedState&&) noexcept = default;
+
+MappedState& MappedState::operator=(MappedState&&) noexcept = default;
+
+index MappedState::constraints() const noexcept
+{
+    return static_cast<index>(m_impl->h.rows);
+}
+
+index MappedState::variables() const noexcept
+{
+    return static_cast<index>(m_impl->h.cols);
+}
+
+index MappedState::nonzeros() const noexcept
+{
+    return static_cast<index>(m_impl->h.nonzeros);
+}
+
+csr_view MappedState::view() const noexcept
+{
+    return csr_view { constraints(), variables(), m_impl->rows_ptr,
+                      m_impl->cols_index, m_impl->values, m_impl->b,
+                      m_impl->c };
+}
+
+bool MappedState::verify() const noexcept
+{
+    checksum sum;
+    sum.update(m_impl->file.data() + sizeof(header),
+               m_impl->file.size() - sizeof(header));
+
+    return sum.value() == m_impl->h.checksum;
+}
+
+} // namespace mitm
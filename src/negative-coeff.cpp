@@ -22,82 +22,111 @@
 
 #include <mitm/mitm.hpp>
 #include <Eigen/Core>
+#include <algorithm>
 #include <iterator>
+#include <vector>
 #include "cstream.hpp"
 #include "internal.hpp"
+#include "sparse-matrix.hpp"
+#include "penalty-matrix.hpp"
+#include "schedule.hpp"
 #include "assert.hpp"
 
 namespace mitm {
 namespace negative {
-struct constraint
+/** constraint_arena packs the buffers of all the constraints in contiguous
+ * arrays in the order of the rows: the reduced costs buffer follows the
+ * CSR order of A and the positions of the negative coefficients are
+ * stored row after row.
+ */
+struct constraint_arena
 {
-    std::vector<mitm::index> I;
-    std::vector<mitm::index> C;
     std::vector<std::tuple<mitm::real, mitm::index>> r;
+    std::vector<mitm::index> negatives;
+};
+
+struct constraint
+{
     mitm::index k;
-    mitm::index n;
+    mitm::index negatives_offset;   ///< first negative position in arena.
+    mitm::index negatives_length;   ///< number of negative coefficients.
     mitm::real bk_lower_bound;
     mitm::real bk_upper_bound;
 
     constraint() = default;
 
-    constraint(mitm::index k_, mitm::index n_,
+    constraint(mitm::index k_,
                mitm::real bk_lower_bound_, mitm::real bk_upper_bound_,
-               const Eigen::MatrixXi& a)
+               const sparse_matrix<int>& a, constraint_arena& arena)
         : k(k_)
+        , negatives_offset(static_cast<mitm::index>(arena.negatives.size()))
+        , negatives_length(0)
         , bk_lower_bound(bk_lower_bound_)
         , bk_upper_bound(bk_upper_bound_)
     {
-        for (mitm::index i = 0; i != n_; ++i) {
-            if (a(k, i) != 0) {
-                I.emplace_back(i);
-
-                if (a(k, i) < 0)           // Find variables with negative
-                    C.emplace_back(i);     // coefficient.
+        for (mitm::index pos = a.row_begin(k), end = a.row_end(k);
+             pos != end; ++pos) {
+            if (a.value(pos) < 0)                   // Find variables with
+                arena.negatives.emplace_back(       // negative coefficient.
+                    pos - a.row_begin(k));
 
-                r.emplace_back(0, i);
-            }
+            arena.r.emplace_back(0, pos - a.row_begin(k));
         }
+
+        negatives_length = static_cast<mitm::index>(arena.negatives.size())
+            - negatives_offset;
     }
 
-    void update(Eigen::MatrixXi& A, const Eigen::RowVectorXf& c,
-                Eigen::MatrixXf& P, Eigen::VectorXf& pi, Eigen::VectorXi& x,
+    void update(sparse_matrix<int>& A, constraint_arena& arena,
+                const Eigen::RowVectorXf& c,
+                penalty_matrix& P, Eigen::VectorXf& pi, Eigen::VectorXi& x,
                 mitm::real kappa, mitm::real l, mitm::real theta)
     {
-        P.row(k) *= theta;
+        const mitm::index begin = A.row_begin(k);
+        const mitm::index length = A.row_length(k);
+        const mitm::index *I = A.row_columns(k);
+        const auto C = arena.negatives.cbegin() + negatives_offset;
+        const auto C_end = C + negatives_length;
+        const auto r = arena.r.begin() + begin;
+        const auto r_end = r + length;
+
+        P.scale(k, theta);
 
-        for (mitm::index i = 0; i != static_cast<mitm::index>(I.size()); ++i) {
+        for (mitm::index i = 0; i != length; ++i) {
             mitm::real sum_a_hi_pi_h = 0;
             mitm::real sum_a_hi_p_hi = 0;
-            for (mitm::index h = 0, endh = A.rows(); h != endh; ++h) {
-                if (A(h, i)) {
-                    sum_a_hi_pi_h += A(h, I[i]) * pi(h);
-                    sum_a_hi_p_hi += A(h, I[i]) * P(h, I[i]);
-                }
+            for (mitm::index cpos = A.col_begin(I[i]), endh = A.col_end(I[i]);
+                 cpos != endh; ++cpos) {
+                const mitm::index h = A.row(cpos);
+                const int a_hi = A.value(A.position(cpos));
+
+                sum_a_hi_pi_h += a_hi * pi(h);
+                sum_a_hi_p_hi += a_hi * P(h, A.position(cpos));
             }
 
             r[i] = std::make_tuple(c(I[i]) - sum_a_hi_pi_h - sum_a_hi_p_hi,
-                                   I[i]);
+                                   i);
         }
 
         auto bk_lower_bound_tmp = bk_lower_bound;
         auto bk_upper_bound_tmp = bk_upper_bound;
 
-        if (not C.empty()) {
+        if (C != C_end) {
             // Find variable with negative coefficient and negate reduced
             // costs and coefficients of these variables.
-            for (mitm::index i : C) {
+            for (auto it = C; it != C_end; ++it) {
+                const mitm::index i = *it;
                 std::get<0>(r[i]) = -std::get<0>(r[i]);
-                A(k, i) = -A(k, i);
-                P(k, i) = -P(k, i);
+                A.value(begin + i) = -A.value(begin + i);
+                P.set(k, begin + i, -P(k, begin + i));
             }
 
             // TODO u(i) = 1 now but we need to update the state structure
             // to insert a u(i) to handle general bounded integer variable
             // (see. 3.1 Bastert).
             mitm::real sum = 0;
-            for (mitm::index i : C)
-                sum += A(k, i) * (1);
+            for (auto it = C; it != C_end; ++it)
+                sum += A.value(begin + *it) * (1);
 
             bk_lower_bound_tmp += sum;
             bk_upper_bound_tmp += sum;
@@ -107,189 +136,306 @@ struct constraint
         // End of update
         //
 
-        std::sort(r.begin(), r.end(),
+        std::sort(r, r_end,
                   [](const std::tuple<mitm::real, mitm::index>& lhs,
                      const std::tuple<mitm::real, mitm::index>& rhs)
                   {
                       return std::get<0>(lhs) < std::get<0>(rhs);
                   });
 
-        std::vector<std::tuple<mitm::real, mitm::index>> computer;
-        std::vector<std::tuple<mitm::real, mitm::index>> no_computer;
-
-        for (auto& sr : r) {
-            if (std::get<0>(sr) >= bk_lower_bound_tmp and
-                std::get<0>(sr) <= bk_upper_bound_tmp)
-                computer.emplace_back(sr);
-            else
-                no_computer.emplace_back(sr);
-        }
-
-        assert(computer.size() >= 2);
-
-        const auto& max_1 = computer[computer.size() - 1];
-        const auto& max_2 = computer[computer.size() - 2];
-
-        pi(k) += (std::get<0>(max_1) + std::get<0>(max_2)) / 2.0;
-
-        const mitm::real delta = ((kappa / (1 - kappa)) * (
-                                 std::get<0>(max_1) -
-                                 std::get<0>(max_2))) + l;
-
-        for (const auto& sr : computer) {
-            x(std::get<1>(sr)) = 1;
-            P(k, std::get<1>(sr)) -= +delta;
+        // The reduced costs in the bounds select the variables, the two
+        // greatest of them give pi and delta.
+        auto in_bounds = [bk_lower_bound_tmp, bk_upper_bound_tmp](
+            const std::tuple<mitm::real, mitm::index>& sr)
+            {
+                return std::get<0>(sr) >= bk_lower_bound_tmp and
+                    std::get<0>(sr) <= bk_upper_bound_tmp;
+            };
+
+        auto max_1 = r_end;
+        auto max_2 = r_end;
+        for (auto it = r_end; it != r and max_2 == r_end; --it) {
+            if (in_bounds(*(it - 1))) {
+                if (max_1 == r_end)
+                    max_1 = it - 1;
+                else
+                    max_2 = it - 1;
+            }
         }
 
-        for (const auto& sr : no_computer) {
-            x(std::get<1>(sr)) = 0;
-            P(k, std::get<1>(sr)) -= -delta;
+        if (max_2 == r_end) {
+            // Fewer than two reduced costs in the bounds, no pi and no
+            // delta: the variable in the bounds, if any, is forced to 1 and
+            // the others to 0.
+            for (auto it = r; it != r_end; ++it)
+                x(I[std::get<1>(*it)]) = it == max_1;
+        } else {
+            pi(k) += (std::get<0>(*max_1) + std::get<0>(*max_2)) / 2.0;
+
+            const mitm::real delta = ((kappa / (1 - kappa)) * (
+                                         std::get<0>(*max_1) -
+                                         std::get<0>(*max_2))) + l;
+
+            for (auto it = r; it != r_end; ++it) {
+                const mitm::index i = std::get<1>(*it);
+
+                if (in_bounds(*it)) {
+                    x(I[i]) = 1;
+                    P.add(k, begin + i, -delta);
+                } else {
+                    x(I[i]) = 0;
+                    P.add(k, begin + i, +delta);
+                }
+            }
         }
 
         // clean up: correct negated costs and adjust value of negated
         // variables.
-        for (mitm::index i : C) {
-            A(k, i) = -A(k, i);
-            P(k, i) = -P(k, i);
+        for (auto it = C; it != C_end; ++it) {
+            const mitm::index i = *it;
+            A.value(begin + i) = -A.value(begin + i);
+            P.set(k, begin + i, -P(k, begin + i));
 
             // TODO u(i) = 1 now but we need to update the state structure
             // to insert a u(i) to handle general bounded integer variable
             // (see. 3.1 Bastert).
-            x(i) = (1) - x(i);
+            x(I[i]) = (1) - x(I[i]);
         }
     }
-
-    friend std::ostream&
-        operator<<(std::ostream& os, const constraint& c)
-        {
-            os << "k: " << c.k << " n: " << c.n << " bk: " << c.bk_lower_bound
-               << ' ' << c.bk_upper_bound << '\n';
-            os << "I: ";
-            std::copy(c.I.cbegin(), c.I.cend(),
-                      std::ostream_iterator<mitm::index>(os, " "));
-
-            os << "\nr: ";
-            for (const auto& t : c.r)
-                os << '[' << std::get<0>(t) << ',' << std::get<1>(t) << "] ";
-
-            return os << '\n';
-        }
 };
 
 struct wedelin_heuristic_with_negative_coeff
 {
+    constraint_arena arena;
     std::vector <constraint> constraints;
-    Eigen::MatrixXi A;
+    sparse_matrix<int> A;
     std::vector <NegativeCoefficient::b_bounds> b;
     Eigen::RowVectorXf c;
     Eigen::VectorXi x;
-    Eigen::MatrixXf P;
+    penalty_matrix P;
     Eigen::VectorXf pi;
+    Eigen::VectorXi ax;
+    std::vector<int> previous;
+    index violations;
+    real objective;
     index m;
     index n;
-    mitm::real kappa;
-    mitm::real l;
-    mitm::real theta;
+    parameters p;
 
     wedelin_heuristic_with_negative_coeff(const NegativeCoefficient &s,
-                                          mitm::index m_, mitm::index n_,
-                                          mitm::real k_, mitm::real l_, mitm::real theta_)
-        : constraints(m_)
-        , A(Eigen::MatrixXi::Zero(m_, n_))
+                                          const parameters &p_)
+        : A(s.a, static_cast<mitm::index>(s.b.size()),
+            static_cast<mitm::index>(s.c.size()))
         , b(s.b)
-        , c(Eigen::RowVectorXf::Zero(n_))
-        , x(Eigen::VectorXi::Zero(n_))
-        , P(Eigen::MatrixXf::Zero(m_, n_))
-        , pi(Eigen::VectorXf::Zero(m_))
-        , m(m_)
-        , n(n_)
-        , kappa(k_)
-        , l(l_)
-        , theta(theta_)
     {
-        {
-            mitm::index longi = 0;
-            for (mitm::index i = 0; i != m; ++i)
-                for (mitm::index j = 0; j != n; ++j, ++longi)
-                    A(i, j) = s.a[longi];
-        }
+        init(s.c, p_);
+    }
+
+    /// The compressed rows of @e s are copied, the update negates the
+    /// negative coefficients in place.
+    wedelin_heuristic_with_negative_coeff(const SparseState &s,
+                                          const parameters &p_)
+        : b(s.bounds)
+    {
+        A.assign(s.constraints(), s.variables(), s.rows_ptr.data(),
+                 s.cols_index.data(),
+                 s.values.empty() ? nullptr : s.values.data());
+
+        init(s.c, p_);
+    }
+
+    void init(const std::vector<mitm::real> &c_, const parameters &p_)
+    {
+        m = A.rows();
+        n = A.cols();
+        p = p_;
+        c = Eigen::RowVectorXf::Zero(n);
+        x = Eigen::VectorXi::Zero(n);
+        P.assign(A);
+        pi = Eigen::VectorXf::Zero(m);
 
         for (mitm::index j = 0; j != n; ++j) {
-            c(j) = s.c[j];
+            c(j) = c_[j];
             x(j) = c(j) <= 0;
         }
 
-        // TODO: intialize parameters delta, kappa.
-        Ensures(kappa >= 0 && kappa < 1, "kappa must be [0..1[");
-        Ensures(l >= 0, "l must be [0..+oo[");
-        Ensures(theta >= 0 && theta <= 1, "theta must be [0..1]");
+        ax = Eigen::VectorXi::Zero(m);
+        violations = 0;
+        for (mitm::index k = 0; k != m; ++k) {
+            for (mitm::index pos = A.row_begin(k), end = A.row_end(k);
+                 pos != end; ++pos)
+                ax(k) += A.value(pos) * x(A.column(pos));
 
-        constraints.clear();
+            if (is_constraint_need_update(k))
+                ++violations;
+        }
+        objective = c * x.cast<mitm::real>();
+
+        // TODO: intialize parameters delta, kappa.
+        Ensures(p.kappa >= 0 && p.kappa < 1, "kappa must be [0..1[");
+        Ensures(p.delta >= 0, "l must be [0..+oo[");
+        Ensures(p.theta >= 0 && p.theta <= 1, "theta must be [0..1]");
+        // A kappa above the default kappa_max is its own bound: only the
+        // schedules raise kappa.
+        p.kappa_max = std::max(p.kappa_max, p.kappa);
+        Ensures(p.kappa_max < 1, "kappa_max must be [kappa..1[");
+        Ensures(p.rate >= 0 && p.rate <= 1, "rate must be [0..1]");
+
+        arena.r.reserve(A.nonzeros());
+        constraints.reserve(m);
         for (mitm::index i = 0; i != m; ++i)
-            constraints.emplace_back(i, n,
-                                     b[i].lower_bound, b[i].upper_bound,
-                                     A);
+            constraints.emplace_back(i, b[i].lower_bound, b[i].upper_bound,
+                                     A, arena);
     }
 
     inline bool
     is_constraint_need_update(mitm::index k) const
     {
-        // TODO: Found a Eigen API (sum(A.row(k) * x(k)) == b(k).
-        int sum = 0;
-        for (mitm::index i = 0; i != n; ++i)
-            sum += A(k, i) * x(i);
+        return not (b[k].lower_bound <= ax(k) and
+                    ax(k) <= b[k].upper_bound);
+    }
+
+    mitm::index violated() const
+    {
+        return violations;
+    }
+
+    mitm::real value() const
+    {
+        return objective;
+    }
+
+    /// Add @e diff times the column @e j to the activities, the objective
+    /// and the number of violated constraints.
+    void shift(mitm::index j, int diff)
+    {
+        for (mitm::index cpos = A.col_begin(j), end = A.col_end(j);
+             cpos != end; ++cpos) {
+            const mitm::index h = A.row(cpos);
+            const bool was_violated = is_constraint_need_update(h);
+
+            ax(h) += A.value(A.position(cpos)) * diff;
+            violations += is_constraint_need_update(h) - was_violated;
+        }
 
-        return b[k].lower_bound <= sum and sum <= b[k].upper_bound;
+        objective += c(j) * diff;
     }
 
+    /// Return true if the current assignment satisfies all the constraints,
+    /// otherwise update the violated constraints.
     bool next()
     {
-        for (mitm::index k = 0; k != m; ++k)
-            if (is_constraint_need_update(k))
-                constraints[k].update(A, c, P, pi, x, kappa, l, theta);
+        for (mitm::index k = 0; k != m; ++k) {
+            if (is_constraint_need_update(k)) {
+                const mitm::index begin = A.row_begin(k);
+                const mitm::index end = A.row_end(k);
+
+                previous.clear();
+                for (mitm::index pos = begin; pos != end; ++pos)
+                    previous.emplace_back(x(A.column(pos)));
+
+                constraints[k].update(A, arena, c, P, pi, x,
+                                      p.kappa, p.delta, p.theta);
+
+                // Only the columns of the row k may change.
+                for (mitm::index pos = begin; pos != end; ++pos) {
+                    const mitm::index j = A.column(pos);
+                    const int diff = x(j) - previous[pos - begin];
+
+                    if (diff)
+                        shift(j, diff);
+                }
+            }
+        }
 
-        // TODO: adjust parameters kappa, delta, theta
+        // An update may violate rows already swept: the success is tested
+        // on the violations tracked by shift(), not on the updated rows.
+        adjust(p, violations, m);
 
-        return false;
+        return violations == 0;
     }
 };
 
 }
 
+namespace {
+
+template <typename Model>
 mitm::result
-heuristic_algorithm_default(const NegativeCoefficient& s, index limit,
-                            mitm::real kappa, mitm::real delta,
-                            mitm::real theta,
-                            const std::string &impl)
+run(const Model &s, const options &o)
 {
-    (void)impl;
+    mitm::negative::wedelin_heuristic_with_negative_coeff wh(s, o.p);
 
-    Expects(s.b.size() > 0 && s.c.size() > 0 &&
-            s.a.size() == s.b.size() * s.c.size(),
-            "heuristic_algorithm_default: state not initialized");
+    Eigen::VectorXi best = wh.x;
+    mitm::index best_violated = wh.violated();
+    mitm::real best_value = wh.value();
+    mitm::index best_loop = 0;
+    mitm::result ret;
+    ret.status = result_status::limit_reached;
 
-    mitm::negative::wedelin_heuristic_with_negative_coeff wh(
-        s,
-        static_cast<mitm::index>(s.b.size()),
-        static_cast<mitm::index>(s.c.size()),
-        kappa, delta, theta);
+    for (long int it = 0; it != o.limit; ++it) {
+        if (is_interrupted(o, ret.status))
+            break;
 
-    for (long int it = 0; it != limit; ++it) {
         if (wh.next()) {
-            mitm::result ret;
+            best = wh.x;
+            best_violated = 0;
+            best_value = wh.value();
+            best_loop = it;
+            ret.status = result_status::success;
+            break;
+        }
 
-            ret.x.resize(wh.x.size());
+        const mitm::index violated = wh.violated();
+        const mitm::real value = wh.value();
+        if (violated < best_violated or
+            (violated == best_violated and value < best_value)) {
+            best = wh.x;
+            best_violated = violated;
+            best_value = value;
+            best_loop = it;
+        }
 
-            for (mitm::index j = 0;
-                 j != static_cast<mitm::index>(s.c.size()); ++j)
-                ret.x[j] = wh.x(j);
+        notify(o, it, violated, value);
+    }
 
-            ret.loop = it;
-            return ret;
-        }
+    // The incremental objective drifts, the value is computed once from
+    // the best assignment.
+    ret.x.resize(best.size());
+    ret.value = 0;
+    for (mitm::index j = 0; j != static_cast<mitm::index>(s.c.size()); ++j) {
+        ret.x[j] = best(j);
+        if (best(j))
+            ret.value += s.c[j];
     }
 
-    throw std::runtime_error("no solution founded");
+    ret.loop = best_loop;
+    ret.violated = best_violated;
+    return ret;
+}
+
+} // anonymous namespace
+
+mitm::result
+heuristic_algorithm_default(const NegativeCoefficient& s,
+                            const options &o)
+{
+    Expects(s.b.size() > 0 && s.c.size() > 0 &&
+            s.a.size() == s.b.size() * s.c.size(),
+            "heuristic_algorithm_default: state not initialized");
+
+    return run(s, o);
+}
+
+mitm::result
+heuristic_algorithm_default(const SparseState& s, const options &o)
+{
+    Expects(s.constraints() > 0 && s.variables() > 0 &&
+            s.rows_ptr.size() == s.b.size() + 1 &&
+            s.bounds.size() == s.b.size(),
+            "heuristic_algorithm_default: bounded state not initialized");
+
+    return run(s, o);
 }
 
 
@@ -0,0 +1,225 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_PENALTY_MATRIX_HPP
+#define FR_INRA_MITM_PENALTY_MATRIX_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+#include <ostream>
+#include <vector>
+#include <cassert>
+#include "sparse-matrix.hpp"
+
+namespace mitm {
+
+/** basic_penalty_matrix stores the penalties P of the Wedelin heuristic on
+ * the non zero pattern of the constraints matrix A, row by row, in the CSR
+ * order of A: P(k, pos) is the penalty of the coefficient at the CSR
+ * position @e pos of A.
+ *
+ * Each row owns a scale factor and the real value is the stored value
+ * times the scale, so the theta decay of a row is O(1). The row is
+ * renormalized when its scale becomes too small.
+ *
+ * @code
+ * mitm::basic_penalty_matrix<float, std::int32_t> P(A);
+ * P.scale(k, theta);
+ * for (auto pos = A.row_begin(k), end = A.row_end(k); pos != end; ++pos)
+ *     P.add(k, pos, -delta);
+ * @endcode
+ */
+template <typename Real, typename Index>
+class basic_penalty_matrix
+{
+    std::vector<Real> m_values;
+    std::vector<Real> m_scale;
+    std::vector<Index> m_rows_ptr;
+
+public:
+    /// Under this scale the row is renormalized.
+    static constexpr Real scale_limit = Real(1e-20);
+
+    template <typename T>
+    explicit basic_penalty_matrix(const sparse_matrix<T, Index> &A);
+
+    basic_penalty_matrix() = default;
+
+    /// Reset to the pattern of @e A with zero penalties, the arrays already
+    /// allocated are reused.
+    template <typename T>
+    void assign(const sparse_matrix<T, Index> &A);
+
+    Index rows() const noexcept;
+    Index nonzeros() const noexcept;
+
+    /// Value of the penalty at the CSR position @e pos of the row @e k.
+    Real operator()(Index k, Index pos) const noexcept;
+
+    void set(Index k, Index pos, Real value) noexcept;
+    void add(Index k, Index pos, Real value) noexcept;
+
+    /// Multiply the row @e k by @e theta.
+    void scale(Index k, Real theta) noexcept;
+
+    /// The stored values of the row @e k: the penalties divided by the
+    /// scale of the row.
+    Real* row_data(Index k) noexcept;
+    Real row_scale(Index k) const noexcept;
+
+    std::size_t size() const noexcept;
+
+    friend std::ostream&
+        operator<<(std::ostream &os, const basic_penalty_matrix &P)
+        {
+            for (Index k = 0; k != P.rows(); ++k) {
+                os << k << ':';
+                for (Index pos = P.m_rows_ptr[k]; pos != P.m_rows_ptr[k + 1];
+                     ++pos)
+                    os << ' ' << P(k, pos);
+                os << '\n';
+            }
+
+            return os;
+        }
+};
+
+//
+// implementation part
+//
+
+template <typename Real, typename Index>
+template <typename T>
+basic_penalty_matrix<Real, Index>::basic_penalty_matrix(
+    const sparse_matrix<T, Index> &A)
+{
+    assign(A);
+}
+
+template <typename Real, typename Index>
+template <typename T>
+void
+basic_penalty_matrix<Real, Index>::assign(const sparse_matrix<T, Index> &A)
+{
+    m_values.assign(A.nonzeros(), 0);
+    m_scale.assign(A.rows(), 1);
+    m_rows_ptr.assign(A.rows() + 1, 0);
+
+    for (Index k = 0; k != A.rows(); ++k)
+        m_rows_ptr[k + 1] = A.row_end(k);
+}
+
+template <typename Real, typename Index>
+inline Index
+basic_penalty_matrix<Real, Index>::rows() const noexcept
+{
+    return static_cast<Index>(m_scale.size());
+}
+
+template <typename Real, typename Index>
+inline Index
+basic_penalty_matrix<Real, Index>::nonzeros() const noexcept
+{
+    return static_cast<Index>(m_values.size());
+}
+
+template <typename Real, typename Index>
+inline Real
+basic_penalty_matrix<Real, Index>::operator()(Index k, Index pos) const
+    noexcept
+{
+    assert(pos >= m_rows_ptr[k] && pos < m_rows_ptr[k + 1]);
+
+    return m_values[pos] * m_scale[k];
+}
+
+template <typename Real, typename Index>
+inline void
+basic_penalty_matrix<Real, Index>::set(Index k, Index pos, Real value)
+    noexcept
+{
+    assert(pos >= m_rows_ptr[k] && pos < m_rows_ptr[k + 1]);
+
+    m_values[pos] = value / m_scale[k];
+}
+
+template <typename Real, typename Index>
+inline void
+basic_penalty_matrix<Real, Index>::add(Index k, Index pos, Real value)
+    noexcept
+{
+    assert(pos >= m_rows_ptr[k] && pos < m_rows_ptr[k + 1]);
+
+    m_values[pos] += value / m_scale[k];
+}
+
+template <typename Real, typename Index>
+inline void
+basic_penalty_matrix<Real, Index>::scale(Index k, Real theta) noexcept
+{
+    assert(k >= 0 && k < rows());
+
+    const Real scale = m_scale[k] * theta;
+
+    // Also handles theta = 0: the stored values are reset to zero and the
+    // scale remains usable by set() and add().
+    if (scale < scale_limit) {
+        std::for_each(m_values.begin() + m_rows_ptr[k],
+                      m_values.begin() + m_rows_ptr[k + 1],
+                      [scale](Real& value) { value *= scale; });
+        m_scale[k] = 1;
+    } else {
+        m_scale[k] = scale;
+    }
+}
+
+template <typename Real, typename Index>
+inline Real*
+basic_penalty_matrix<Real, Index>::row_data(Index k) noexcept
+{
+    assert(k >= 0 && k < rows());
+
+    return m_values.data() + m_rows_ptr[k];
+}
+
+template <typename Real, typename Index>
+inline Real
+basic_penalty_matrix<Real, Index>::row_scale(Index k) const noexcept
+{
+    assert(k >= 0 && k < rows());
+
+    return m_scale[k];
+}
+
+template <typename Real, typename Index>
+inline std::size_t
+basic_penalty_matrix<Real, Index>::size() const noexcept
+{
+    return (m_values.size() + m_scale.size()) * sizeof(Real) +
+        m_rows_ptr.size() * sizeof(Index);
+}
+
+using penalty_matrix = basic_penalty_matrix<real, index>;
+
+}
+
+#endif
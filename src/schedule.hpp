@@ -0,0 +1,85 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_SCHEDULE_HPP
+#define FR_INRA_MITM_SCHEDULE_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+
+namespace mitm {
+
+/** Update kappa and theta of @e p after a loop which left @e violated of
+ * the @e m constraints violated.
+ */
+inline void
+adjust(parameters &p, index violated, index m) noexcept
+{
+    switch (p.policy) {
+    case schedule::constant:
+        break;
+
+    case schedule::geometric:
+        p.kappa = std::min(p.kappa_max, p.kappa * (1 + p.rate));
+        break;
+
+    case schedule::violation:
+        p.kappa = std::min(p.kappa_max,
+                           p.kappa + (p.kappa_max - p.kappa) * p.rate *
+                           static_cast<real>(violated) /
+                           static_cast<real>(m));
+        break;
+
+    case schedule::annealing:
+        p.theta = std::min(real(1), p.theta + (1 - p.theta) * p.rate);
+        break;
+    }
+}
+
+inline const char*
+schedule_name(schedule s) noexcept
+{
+    switch (s) {
+    case schedule::constant: return "constant";
+    case schedule::geometric: return "geometric";
+    case schedule::violation: return "violation";
+    case schedule::annealing: return "annealing";
+    }
+
+    return "unknown";
+}
+
+inline const char*
+sweep_name(sweep s) noexcept
+{
+    switch (s) {
+    case sweep::all: return "all";
+    case sweep::worklist: return "worklist";
+    case sweep::violation: return "violation";
+    }
+
+    return "unknown";
+}
+
+} // namespace mitm
+
+#endif
@@ -0,0 +1,481 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_SPARSE_MATRIX_HPP
+#define FR_INRA_MITM_SPARSE_MATRIX_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <vector>
+#include <cassert>
+
+namespace mitm {
+
+/** sparse_matrix stores only the non zero coefficients of a matrix.
+ *
+ * The coefficients are stored in a row-major compressed form (CSR) and an
+ * additional column-major index (CSC) gives, for each column, the rows and
+ * the position in the CSR arrays of its coefficients. Memory and access
+ * cost are proportional to the number of non zero coefficients. @e Index
+ * is the integer type of the positions and must hold the number of non
+ * zero coefficients.
+ *
+ * The CSR arrays are owned by the matrix or, after attach(), by the caller:
+ * then only the column index is built and stored.
+ *
+ * @code
+ * mitm::sparse_matrix<int> A(dense, m, n);
+ * for (auto pos = A.row_begin(k), end = A.row_end(k); pos != end; ++pos)
+ *     std::cout << A.column(pos) << ' ' << A.value(pos) << '\n';
+ * @endcode
+ */
+template <typename T, typename Index = index>
+class sparse_matrix
+{
+public:
+    using value_type = T;
+    using index_type = Index;
+
+private:
+    std::vector<Index> m_rows_ptr;
+    std::vector<Index> m_cols_index;
+    std::vector<T> m_values;
+
+    // The CSR arrays used by the accessors: the vectors above or the arrays
+    // of attach(). Without values, the coefficients are the ones of
+    // m_ones, as long as the longest row.
+    const Index *m_rows_ptr_data = nullptr;
+    const Index *m_cols_index_data = nullptr;
+    const T *m_values_data = nullptr;
+    std::vector<T> m_ones;
+
+    std::vector<Index> m_cols_ptr;
+    std::vector<Index> m_rows_index;
+    std::vector<Index> m_cols_position;
+
+    Index m_rows = 0;
+    Index m_cols = 0;
+
+public:
+    /** Build the sparse matrix from a dense row-major container.
+     *
+     * @param dense [in] the linear container of @e rows * @e cols values.
+     * @param rows [in] number of row.
+     * @param cols [in] number of column.
+     */
+    template <typename Container>
+    sparse_matrix(const Container &dense, Index rows, Index cols);
+
+    /// Rebuild the matrix from @e dense as the constructor, the arrays
+    /// already allocated are reused.
+    template <typename Container>
+    void assign(const Container &dense, Index rows, Index cols);
+
+    /// Rebuild the matrix from a copy of the CSR arrays of the caller,
+    /// as attach() but the values may be changed.
+    void assign(Index rows, Index cols, const Index *rows_ptr,
+                const Index *cols_index, const T *values);
+
+    /** Use the CSR arrays of the caller without copy. They must outlive
+     * the matrix or the next assign() or attach().
+     *
+     * @param rows_ptr [in] the @e rows + 1 positions of the rows,
+     * rows_ptr[0] = 0.
+     * @param cols_index [in] the column of each coefficient, distinct in a
+     * row.
+     * @param values [in] the value of each coefficient or nullptr if all
+     * the coefficients are 1.
+     */
+    void attach(Index rows, Index cols, const Index *rows_ptr,
+                const Index *cols_index, const T *values);
+
+    /// Returns true if the CSR arrays are the ones of attach().
+    bool is_attached() const noexcept;
+
+    sparse_matrix() = default;
+    sparse_matrix(const sparse_matrix& q);
+    sparse_matrix(sparse_matrix&& q) = default;
+    sparse_matrix& operator=(const sparse_matrix& q);
+    sparse_matrix& operator=(sparse_matrix&& q) = default;
+    ~sparse_matrix() = default;
+
+    Index rows() const noexcept;
+    Index cols() const noexcept;
+    Index nonzeros() const noexcept;
+
+    /// Positions range in the CSR arrays of the coefficients of row @e k.
+    Index row_begin(Index k) const noexcept;
+    Index row_end(Index k) const noexcept;
+    Index row_length(Index k) const noexcept;
+
+    /// The columns of the coefficients of row @e k, contiguous in memory.
+    const Index* row_columns(Index k) const noexcept;
+
+    /// The coefficients of row @e k, contiguous in memory.
+    const T* row_values(Index k) const noexcept;
+
+    /// Column and value of the coefficient at the CSR position @e pos.
+    Index column(Index pos) const noexcept;
+    const T& value(Index pos) const noexcept;
+    T& value(Index pos) noexcept;
+
+    /// Positions range in the CSC arrays of the coefficients of column @e j.
+    Index col_begin(Index j) const noexcept;
+    Index col_end(Index j) const noexcept;
+
+    /// Row and CSR position of the coefficient at the CSC position @e cpos.
+    Index row(Index cpos) const noexcept;
+    Index position(Index cpos) const noexcept;
+
+    std::size_t size() const noexcept;
+
+private:
+    void build_columns();
+
+public:
+    friend std::ostream&
+        operator<<(std::ostream &os, const sparse_matrix &s)
+        {
+            for (Index k = 0; k != s.rows(); ++k) {
+                os << k << ':';
+                for (Index pos = s.row_begin(k); pos != s.row_end(k); ++pos)
+                    os << ' ' << s.column(pos) << '(' << s.value(pos) << ')';
+                os << '\n';
+            }
+
+            return os;
+        }
+};
+
+//
+// implementation part
+//
+
+template <typename T, typename Index>
+template <typename Container>
+sparse_matrix<T, Index>::sparse_matrix(const Container &dense,
+                                       Index rows_, Index cols_)
+{
+    assign(dense, rows_, cols_);
+}
+
+template <typename T, typename Index>
+template <typename Container>
+void
+sparse_matrix<T, Index>::assign(const Container &dense,
+                                Index rows_, Index cols_)
+{
+    assert(static_cast<index>(dense.size()) ==
+           static_cast<index>(rows_) * static_cast<index>(cols_));
+
+    m_rows = rows_;
+    m_cols = cols_;
+    m_rows_ptr.assign(rows_ + 1, 0);
+    m_cols_index.clear();
+    m_values.clear();
+    m_ones.clear();
+
+    {
+        index longi = 0;
+        for (Index i = 0; i != m_rows; ++i) {
+            for (Index j = 0; j != m_cols; ++j, ++longi) {
+                if (dense[longi]) {
+                    m_cols_index.emplace_back(j);
+                    m_values.emplace_back(static_cast<T>(dense[longi]));
+                }
+            }
+
+            assert(m_cols_index.size() <=
+                   static_cast<std::size_t>(std::numeric_limits<Index>::max()));
+
+            m_rows_ptr[i + 1] = static_cast<Index>(m_cols_index.size());
+        }
+    }
+
+    m_rows_ptr_data = m_rows_ptr.data();
+    m_cols_index_data = m_cols_index.data();
+    m_values_data = m_values.data();
+
+    build_columns();
+}
+
+template <typename T, typename Index>
+void
+sparse_matrix<T, Index>::assign(Index rows_, Index cols_,
+                                const Index *rows_ptr,
+                                const Index *cols_index, const T *values)
+{
+    assert(rows_ptr && cols_index && rows_ptr[0] == 0);
+
+    m_rows = rows_;
+    m_cols = cols_;
+    m_rows_ptr.assign(rows_ptr, rows_ptr + rows_ + 1);
+    m_cols_index.assign(cols_index, cols_index + rows_ptr[rows_]);
+    if (values)
+        m_values.assign(values, values + rows_ptr[rows_]);
+    else
+        m_values.assign(rows_ptr[rows_], T(1));
+    m_ones.clear();
+
+    m_rows_ptr_data = m_rows_ptr.data();
+    m_cols_index_data = m_cols_index.data();
+    m_values_data = m_values.data();
+
+    build_columns();
+}
+
+template <typename T, typename Index>
+void
+sparse_matrix<T, Index>::attach(Index rows_, Index cols_,
+                                const Index *rows_ptr,
+                                const Index *cols_index, const T *values)
+{
+    assert(rows_ptr && cols_index && rows_ptr[0] == 0);
+
+    m_rows = rows_;
+    m_cols = cols_;
+    m_rows_ptr.clear();
+    m_cols_index.clear();
+    m_values.clear();
+    m_rows_ptr_data = rows_ptr;
+    m_cols_index_data = cols_index;
+    m_values_data = values;
+
+    Index longest = 1;
+    for (Index k = 0; k != m_rows; ++k)
+        longest = std::max(longest, row_length(k));
+
+    if (values)
+        m_ones.clear();
+    else
+        m_ones.assign(longest, T(1));
+
+    build_columns();
+}
+
+template <typename T, typename Index>
+void
+sparse_matrix<T, Index>::build_columns()
+{
+    m_cols_ptr.assign(m_cols + 1, 0);
+    m_rows_index.resize(nonzeros());
+    m_cols_position.resize(nonzeros());
+
+    for (Index pos = 0, end = nonzeros(); pos != end; ++pos) {
+        assert(m_cols_index_data[pos] >= 0 &&
+               m_cols_index_data[pos] < m_cols);
+
+        ++m_cols_ptr[m_cols_index_data[pos] + 1];
+    }
+
+    for (Index j = 0; j != m_cols; ++j)
+        m_cols_ptr[j + 1] += m_cols_ptr[j];
+
+    // m_cols_ptr[j] is used as the next free CSC position of the column j
+    // then shifted back to the beginning of the column.
+    for (Index i = 0; i != m_rows; ++i) {
+        for (Index pos = m_rows_ptr_data[i]; pos != m_rows_ptr_data[i + 1];
+             ++pos) {
+            Index cpos = m_cols_ptr[m_cols_index_data[pos]]++;
+            m_rows_index[cpos] = i;
+            m_cols_position[cpos] = pos;
+        }
+    }
+
+    for (Index j = m_cols - 1; j > 0; --j)
+        m_cols_ptr[j] = m_cols_ptr[j - 1];
+    if (m_cols > 0)
+        m_cols_ptr[0] = 0;
+}
+
+template <typename T, typename Index>
+sparse_matrix<T, Index>::sparse_matrix(const sparse_matrix& q)
+    : sparse_matrix()
+{
+    *this = q;
+}
+
+template <typename T, typename Index>
+sparse_matrix<T, Index>&
+sparse_matrix<T, Index>::operator=(const sparse_matrix& q)
+{
+    // The copies of the owned arrays are rebound, the attached arrays are
+    // shared.
+    m_rows_ptr = q.m_rows_ptr;
+    m_cols_index = q.m_cols_index;
+    m_values = q.m_values;
+    m_ones = q.m_ones;
+    m_cols_ptr = q.m_cols_ptr;
+    m_rows_index = q.m_rows_index;
+    m_cols_position = q.m_cols_position;
+    m_rows = q.m_rows;
+    m_cols = q.m_cols;
+
+    if (q.is_attached()) {
+        m_rows_ptr_data = q.m_rows_ptr_data;
+        m_cols_index_data = q.m_cols_index_data;
+        m_values_data = q.m_values_data;
+    } else {
+        m_rows_ptr_data = m_rows_ptr.data();
+        m_cols_index_data = m_cols_index.data();
+        m_values_data = m_values.data();
+    }
+
+    return *this;
+}
+
+template <typename T, typename Index>
+inline bool
+sparse_matrix<T, Index>::is_attached() const noexcept
+{
+    return m_rows_ptr_data and m_rows_ptr_data != m_rows_ptr.data();
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::rows() const noexcept
+{
+    return m_rows;
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::cols() const noexcept
+{
+    return m_cols;
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::nonzeros() const noexcept
+{
+    return m_rows_ptr_data ? m_rows_ptr_data[m_rows] : 0;
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::row_begin(Index k) const noexcept
+{
+    assert(k >= 0 && k < m_rows);
+
+    return m_rows_ptr_data[k];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::row_end(Index k) const noexcept
+{
+    assert(k >= 0 && k < m_rows);
+
+    return m_rows_ptr_data[k + 1];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::row_length(Index k) const noexcept
+{
+    return row_end(k) - row_begin(k);
+}
+
+template <typename T, typename Index>
+inline const Index*
+sparse_matrix<T, Index>::row_columns(Index k) const noexcept
+{
+    return m_cols_index_data + row_begin(k);
+}
+
+template <typename T, typename Index>
+inline const T*
+sparse_matrix<T, Index>::row_values(Index k) const noexcept
+{
+    return m_values_data ? m_values_data + row_begin(k) : m_ones.data();
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::column(Index pos) const noexcept
+{
+    return m_cols_index_data[pos];
+}
+
+template <typename T, typename Index>
+inline const T&
+sparse_matrix<T, Index>::value(Index pos) const noexcept
+{
+    return m_values_data ? m_values_data[pos] : m_ones[0];
+}
+
+template <typename T, typename Index>
+inline T&
+sparse_matrix<T, Index>::value(Index pos) noexcept
+{
+    assert(not is_attached());
+
+    return m_values[pos];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::col_begin(Index j) const noexcept
+{
+    assert(j >= 0 && j < m_cols);
+
+    return m_cols_ptr[j];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::col_end(Index j) const noexcept
+{
+    assert(j >= 0 && j < m_cols);
+
+    return m_cols_ptr[j + 1];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::row(Index cpos) const noexcept
+{
+    return m_rows_index[cpos];
+}
+
+template <typename T, typename Index>
+inline Index
+sparse_matrix<T, Index>::position(Index cpos) const noexcept
+{
+    return m_cols_position[cpos];
+}
+
+template <typename T, typename Index>
+inline std::size_t
+sparse_matrix<T, Index>::size() const noexcept
+{
+    return (m_rows_ptr.size() + m_cols_index.size() + m_cols_ptr.size() +
+            m_rows_index.size() + m_cols_position.size()) * sizeof(Index) +
+        (m_values.size() + m_ones.size()) * sizeof(T) + 2 * sizeof(Index);
+}
+
+} // namespace mitm
+
+#endif
@@ -0,0 +1,328 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_TEXT_CHUNKS_HPP
+#define FR_INRA_MITM_TEXT_CHUNKS_HPP
+
+#include <mitm/mitm.hpp>
+#include "text-scanner.hpp"
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mitm {
+
+/// The threads and the smallest chunk of the parallel readers.
+struct chunk_policy
+{
+    chunk_policy(unsigned threads_ = std::thread::hardware_concurrency(),
+                 std::size_t chunk_size_ = 1u << 20)
+        : threads(std::max(threads_, 1u))
+        , chunk_size(std::max(chunk_size_, std::size_t(1)))
+    {}
+
+    unsigned threads;
+    std::size_t chunk_size;
+};
+
+/// Reads the text model of @e filename as load() with @e policy.
+void load(const std::string &filename, SparseState &s,
+          const chunk_policy &policy);
+
+/// Reads the MPS file @e filename as load_mps() with @e policy.
+void load_mps(const std::string &filename, SparseState &s,
+              const chunk_policy &policy);
+
+/** Splits [first, last[ in about four chunks per thread of chunk_size bytes
+ * at least. The chunks after the first start at the beginning of a line:
+ * a token or a comment never spans two chunks.
+ */
+inline std::vector<std::pair<const char*, const char*>>
+split_lines(const char *first, const char *last, const chunk_policy &policy)
+{
+    const std::size_t size = static_cast<std::size_t>(last - first);
+    const std::size_t count = std::max(
+        std::size_t(1), std::min(std::size_t(4) * policy.threads,
+                                 size / policy.chunk_size));
+
+    std::vector<std::pair<const char*, const char*>> ret;
+    ret.reserve(count);
+
+    const char *begin = first;
+    for (std::size_t i = 1; i < count and begin != last; ++i) {
+        const char *target = first + size / count * i;
+        if (target < begin)
+            continue;
+
+        const char *end = static_cast<const char*>(
+            std::memchr(target, '\n', static_cast<std::size_t>(last - target)));
+        end = end ? end + 1 : last;
+
+        ret.emplace_back(begin, end);
+        begin = end;
+    }
+
+    if (begin != last or ret.empty())
+        ret.emplace_back(begin, last);
+
+    return ret;
+}
+
+/** token_chunks converts the integer tokens of a text in parallel. The
+ * text is split by split_lines(), each chunk keeps its integers (0 for the
+ * other tokens) and the rank of the other tokens, the chunks are read in
+ * order by a cursor. The errors are the ones of a text_scanner reading the
+ * text from the start, whatever the chunks.
+ */
+class token_chunks
+{
+    struct chunk
+    {
+        const char *first;
+        const char *last;
+        int line;                       ///< line of first.
+        std::size_t offset;             ///< rank of the first token.
+        std::vector<index> values;      ///< the integer tokens.
+        std::vector<std::size_t> others; ///< where the other tokens are.
+        std::exception_ptr error;
+    };
+
+    std::vector<chunk> m_chunks;
+    std::size_t m_size;
+    int m_last_line;
+    thread_pool m_pool;
+
+    std::size_t chunk_of(std::size_t token) const noexcept
+    {
+        auto it = std::upper_bound(
+            m_chunks.begin(), m_chunks.end(), token,
+            [](std::size_t value, const chunk &c)
+            {
+                return value < c.offset;
+            });
+
+        return static_cast<std::size_t>(it - m_chunks.begin()) - 1;
+    }
+
+    /// A scanner on the token of rank @e token.
+    text_scanner scanner(std::size_t token) const noexcept
+    {
+        const chunk &c = m_chunks[chunk_of(token)];
+        text_scanner ret(c.first, c.last, c.line);
+
+        for (std::size_t i = c.offset; i != token; ++i)
+            ret.skip_token();
+
+        ret.skip();
+
+        return ret;
+    }
+
+    token_chunks(
+        const std::vector<std::pair<const char*, const char*>> &ranges,
+        int line, unsigned threads)
+        : m_size(0)
+        , m_last_line(line)
+        , m_pool(std::min(threads, static_cast<unsigned>(ranges.size())))
+    {
+        m_chunks.resize(ranges.size());
+        for (std::size_t k = 0; k != ranges.size(); ++k) {
+            m_chunks[k].first = ranges[k].first;
+            m_chunks[k].last = ranges[k].second;
+        }
+
+        std::vector<int> lines(m_chunks.size());
+
+        m_pool.parallel_for(
+            static_cast<index>(m_chunks.size()),
+            [this, &lines](unsigned, index k)
+            {
+                chunk &c = m_chunks[k];
+                text_scanner scanner(c.first, c.last);
+
+                try {
+                    while (scanner.skip()) {
+                        index value = 0;
+                        if (not scanner.try_integer(value)) {
+                            c.others.push_back(c.values.size());
+                            scanner.skip_token();
+                        }
+
+                        c.values.push_back(value);
+                    }
+                } catch (...) {
+                    c.error = std::current_exception();
+                }
+
+                lines[k] = scanner.line();
+            });
+
+        for (std::size_t k = 0; k != m_chunks.size(); ++k) {
+            if (m_chunks[k].error)
+                std::rethrow_exception(m_chunks[k].error);
+
+            m_chunks[k].line = m_last_line;
+            m_chunks[k].offset = m_size;
+            m_last_line += lines[k];
+            m_size += m_chunks[k].values.size();
+        }
+    }
+
+public:
+    /// Converts the tokens of [first, last[, @e first is on the line
+    /// @e line.
+    token_chunks(const char *first, const char *last, int line,
+                 const chunk_policy &policy)
+        : token_chunks(split_lines(first, last, policy), line,
+                       policy.threads)
+    {}
+
+    /// Number of tokens.
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// The line of the token of rank @e token or the last line.
+    int line(std::size_t token) const noexcept
+    {
+        return token >= m_size ? m_last_line : scanner(token).line();
+    }
+
+    /// Throws io_error with @e message at the line of the token of rank
+    /// @e token.
+    [[noreturn]] void error(std::size_t token, const char *message) const
+    {
+        throw io_error(message, line(token));
+    }
+
+    /** Reads the tokens of rank [first, first + count[ as reals in
+     * @e out, in parallel. Throws the error of the first token which is
+     * not a real or the end of the text.
+     */
+    template <typename Real>
+    void reals(std::size_t first, std::size_t count, Real *out)
+    {
+        const std::size_t last = first + count;
+
+        m_pool.parallel_for(
+            static_cast<index>(m_chunks.size()),
+            [this, first, last, out](unsigned, index k)
+            {
+                chunk &c = m_chunks[k];
+                const std::size_t begin = std::max(first, c.offset);
+                const std::size_t end = std::min(
+                    last, c.offset + c.values.size());
+
+                if (begin >= end)
+                    return;
+
+                try {
+                    text_scanner scanner = this->scanner(begin);
+                    for (std::size_t i = begin; i != end; ++i)
+                        out[i - first] = scanner.next_real<Real>();
+                } catch (...) {
+                    c.error = std::current_exception();
+                }
+            });
+
+        for (const auto &c : m_chunks)
+            if (c.error)
+                std::rethrow_exception(c.error);
+
+        if (last > m_size)
+            error(m_size, "unwanted end of stream");
+    }
+
+    /// Reads the integers in the order of the text.
+    class cursor
+    {
+        const token_chunks &m_tokens;
+        std::size_t m_chunk;
+        std::size_t m_pos;
+        std::size_t m_other;
+        std::size_t m_rank;
+
+    public:
+        explicit cursor(const token_chunks &tokens) noexcept
+            : m_tokens(tokens)
+            , m_chunk(0)
+            , m_pos(0)
+            , m_other(0)
+            , m_rank(0)
+        {}
+
+        /// Rank of the next token.
+        std::size_t rank() const noexcept
+        {
+            return m_rank;
+        }
+
+        /// Throws io_error with @e message at the line of the last token.
+        [[noreturn]] void error(const char *message) const
+        {
+            m_tokens.error(m_rank - 1, message);
+        }
+
+        template <typename Integer>
+        Integer next()
+        {
+            while (m_chunk != m_tokens.m_chunks.size() and
+                   m_pos == m_tokens.m_chunks[m_chunk].values.size()) {
+                ++m_chunk;
+                m_pos = 0;
+                m_other = 0;
+            }
+
+            if (m_chunk == m_tokens.m_chunks.size())
+                m_tokens.error(m_rank, "unwanted end of stream");
+
+            const chunk &c = m_tokens.m_chunks[m_chunk];
+            if (m_other != c.others.size() and c.others[m_other] == m_pos) {
+                // Not an integer: the scanner throws the error of the
+                // token.
+                text_scanner scanner = m_tokens.scanner(m_rank);
+                scanner.next_integer<Integer>();
+            }
+
+            const index value = c.values[m_pos++];
+            ++m_rank;
+
+            if (value < static_cast<index>(
+                    std::numeric_limits<Integer>::min()) or
+                value > static_cast<index>(
+                    std::numeric_limits<Integer>::max()))
+                error("integer overflow");
+
+            return static_cast<Integer>(value);
+        }
+    };
+};
+
+}
+
+#endif
@@ -0,0 +1,372 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_TEXT_SCANNER_HPP
+#define FR_INRA_MITM_TEXT_SCANNER_HPP
+
+#include <mitm/mitm.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace mitm {
+
+/** text_scanner reads the tokens of a model text in memory: integers,
+ * booleans and reals separated by spaces, '#' starts a comment until the
+ * end of the line. The numbers are converted in place without locale nor
+ * allocation. On error, an io_error gives the line of the token, counted
+ * from 0 as the stream operator does.
+ *
+ * @code
+ * mitm::mapped_file file(filename);
+ * mitm::text_scanner scanner(file.data(), file.data() + file.size());
+ * auto m = scanner.next_integer<mitm::index>();
+ * @endcode
+ */
+class text_scanner
+{
+    const char *m_first;
+    const char *m_last;
+    int m_line;
+
+public:
+    text_scanner(const char *first, const char *last, int line = 0) noexcept
+        : m_first(first)
+        , m_last(last)
+        , m_line(line)
+    {}
+
+    int line() const noexcept
+    {
+        return m_line;
+    }
+
+    /// Skip the spaces and the comments, returns false at the end.
+    bool skip() noexcept;
+
+    /// The position of the scanner in the text.
+    const char* position() const noexcept
+    {
+        return m_first;
+    }
+
+    template <typename Integer>
+    Integer next_integer();
+
+    /// Reads an integer as next_integer() but returns false, without
+    /// moving, at the end or if the token is not an integer.
+    template <typename Integer>
+    bool try_integer(Integer &value) noexcept;
+
+    /// Moves after the current token, returns false at the end.
+    bool skip_token() noexcept;
+
+    /// A 0 or 1 token.
+    bool next_bool();
+
+    template <typename Real>
+    Real next_real();
+
+    [[noreturn]] void error(const char *message) const
+    {
+        throw io_error(message, m_line);
+    }
+
+private:
+    /// Starts the next token or throws at the end of the text.
+    void start();
+
+    /// Throws if the token does not end at @e ptr.
+    void finish(const char *ptr);
+
+    static bool is_end(const char *ptr, const char *last) noexcept
+    {
+        return ptr == last or *ptr == ' ' or *ptr == '\t' or
+            *ptr == '\r' or *ptr == '\n' or *ptr == '#';
+    }
+
+    /// Converts the integer token at m_first, returns its end or nullptr
+    /// and the reason in @e message.
+    template <typename Integer>
+    const char* parse_integer(Integer &value, const char *&message) const
+        noexcept;
+
+    static bool is_digit(char c) noexcept
+    {
+        return static_cast<unsigned>(c - '0') < 10u;
+    }
+};
+
+inline bool
+text_scanner::skip() noexcept
+{
+    while (m_first != m_last) {
+        switch (*m_first) {
+        case '#':
+            while (m_first != m_last and *m_first != '\n')
+                ++m_first;
+            break;
+
+        case '\n':
+            ++m_line;
+            ++m_first;
+            break;
+
+        case ' ':
+        case '\t':
+        case '\r':
+            ++m_first;
+            break;
+
+        default:
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void
+text_scanner::start()
+{
+    if (not skip())
+        error("unwanted end of stream");
+}
+
+inline void
+text_scanner::finish(const char *ptr)
+{
+    if (not is_end(ptr, m_last))
+        error("fail to read stream");
+
+    m_first = ptr;
+}
+
+template <typename Integer>
+const char*
+text_scanner::parse_integer(Integer &result, const char *&message) const
+    noexcept
+{
+    static_assert(std::is_integral<Integer>::value, "integer type expected");
+
+    const char *ptr = m_first;
+    const bool negative = *ptr == '-';
+    if (*ptr == '-' or *ptr == '+')
+        ++ptr;
+
+    message = "fail to read stream";
+    if (ptr == m_last or not is_digit(*ptr))
+        return nullptr;
+
+    const std::uint64_t limit = negative ?
+        static_cast<std::uint64_t>(std::numeric_limits<Integer>::max()) + 1u
+        : static_cast<std::uint64_t>(std::numeric_limits<Integer>::max());
+    std::uint64_t value = 0;
+
+    for (; ptr != m_last and is_digit(*ptr); ++ptr) {
+        value = value * 10u + static_cast<unsigned>(*ptr - '0');
+
+        if (value > limit) {
+            message = "integer overflow";
+            return nullptr;
+        }
+    }
+
+    if (negative and not std::is_signed<Integer>::value and value != 0) {
+        message = "integer overflow";
+        return nullptr;
+    }
+
+    if (not is_end(ptr, m_last))
+        return nullptr;
+
+    result = negative ? static_cast<Integer>(0u - value)
+        : static_cast<Integer>(value);
+
+    return ptr;
+}
+
+template <typename Integer>
+Integer
+text_scanner::next_integer()
+{
+    start();
+
+    Integer value;
+    const char *message;
+    const char *ptr = parse_integer(value, message);
+
+    if (not ptr)
+        error(message);
+
+    m_first = ptr;
+
+    return value;
+}
+
+template <typename Integer>
+bool
+text_scanner::try_integer(Integer &value) noexcept
+{
+    if (not skip())
+        return false;
+
+    const char *message;
+    const char *ptr = parse_integer(value, message);
+
+    if (not ptr)
+        return false;
+
+    m_first = ptr;
+
+    return true;
+}
+
+inline bool
+text_scanner::skip_token() noexcept
+{
+    if (not skip())
+        return false;
+
+    while (not is_end(m_first, m_last))
+        ++m_first;
+
+    return true;
+}
+
+inline bool
+text_scanner::next_bool()
+{
+    start();
+
+    if (*m_first != '0' and *m_first != '1')
+        error("fail to read stream");
+
+    const bool ret = *m_first == '1';
+    finish(m_first + 1);
+
+    return ret;
+}
+
+template <typename Real>
+Real
+text_scanner::next_real()
+{
+    static_assert(std::is_floating_point<Real>::value, "real type expected");
+
+    start();
+
+    // Exact powers of ten: a mantissa exact in Real times an exact power
+    // is correctly rounded (Clinger's fast path), up to 2^53 and 10^22 in
+    // double, 2^24 and 10^10 in float. A double result rounded again to
+    // float may be 1 ulp off, the float path computes in float. Otherwise
+    // strtod() or strtof() converts a copy of the token.
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    static const float float_powers[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+    const char *ptr = m_first;
+    const bool negative = *ptr == '-';
+    if (*ptr == '-' or *ptr == '+')
+        ++ptr;
+
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    for (; ptr != m_last and is_digit(*ptr); ++ptr, any = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10u + static_cast<unsigned>(*ptr - '0');
+            digits += mantissa != 0;
+        } else {
+            ++exponent;
+        }
+    }
+
+    if (ptr != m_last and *ptr == '.') {
+        for (++ptr; ptr != m_last and is_digit(*ptr); ++ptr, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10u + static_cast<unsigned>(*ptr - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+
+    if (not any)
+        error("fail to read stream");
+
+    if (ptr != m_last and (*ptr == 'e' or *ptr == 'E')) {
+        ++ptr;
+        const bool negative_exponent = ptr != m_last and *ptr == '-';
+        if (ptr != m_last and (*ptr == '-' or *ptr == '+'))
+            ++ptr;
+
+        if (ptr == m_last or not is_digit(*ptr))
+            error("fail to read stream");
+
+        int value = 0;
+        for (; ptr != m_last and is_digit(*ptr); ++ptr)
+            if (value < 100000)
+                value = value * 10 + (*ptr - '0');
+
+        exponent += negative_exponent ? -value : value;
+    }
+
+    const char *first = m_first;
+    finish(ptr);
+
+    if (std::is_same<Real, float>::value) {
+        if (mantissa <= (std::uint64_t(1) << 24) and exponent >= -10 and
+            exponent <= 10) {
+            float ret = static_cast<float>(mantissa);
+            ret = exponent < 0 ? ret / float_powers[-exponent] :
+                ret * float_powers[exponent];
+
+            return static_cast<Real>(negative ? -ret : ret);
+        }
+
+        const std::string token(first, ptr);
+        return static_cast<Real>(std::strtof(token.c_str(), nullptr));
+    }
+
+    if (mantissa <= (std::uint64_t(1) << 53) and exponent >= -22 and
+        exponent <= 22) {
+        double ret = static_cast<double>(mantissa);
+        ret = exponent < 0 ? ret / powers[-exponent] : ret * powers[exponent];
+
+        return static_cast<Real>(negative ? -ret : ret);
+    }
+
+    const std::string token(first, ptr);
+
+    return static_cast<Real>(std::strtod(token.c_str(), nullptr));
+}
+
+}
+
+#endif
@@ -0,0 +1,195 @@
+/* Copyright (C) 2015 INRA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FR_INRA_MITM_THREAD_POOL_HPP
+#define FR_INRA_MITM_THREAD_POOL_HPP
+
+#include <mitm/mitm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mitm {
+
+/** thread_pool runs loops over a set of persistent threads.
+ *
+ * The calling thread takes part to the loop as the worker 0, the other
+ * workers are numbered from 1 to size() - 1. parallel_for returns when all
+ * iterations are done so it can be used as a barrier between two phases.
+ *
+ * @code
+ * mitm::thread_pool pool(4);
+ * pool.parallel_for(n, [&](unsigned worker, mitm::index i)
+ *                   {
+ *                       sum[worker] += v[i];
+ *                   });
+ * @endcode
+ */
+class thread_pool
+{
+public:
+    using function_type = std::function<void(unsigned, index)>;
+
+    explicit thread_pool(unsigned thread_number);
+    ~thread_pool() noexcept;
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// Number of workers, including the calling thread.
+    unsigned size() const noexcept;
+
+    /// Call @e fn(worker, i) for each i in [0, count[.
+    void parallel_for(index count, const function_type& fn);
+
+private:
+    void work(unsigned id) noexcept;
+    void execute(unsigned id) noexcept;
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const function_type *m_fn;
+    std::atomic<index> m_next;
+    index m_count;
+    index m_chunk;
+    unsigned m_running;
+    unsigned long m_generation;
+    bool m_stop;
+};
+
+//
+// implementation part
+//
+
+inline
+thread_pool::thread_pool(unsigned thread_number)
+    : m_fn(nullptr)
+    , m_next(0)
+    , m_count(0)
+    , m_chunk(1)
+    , m_running(0)
+    , m_generation(0)
+    , m_stop(false)
+{
+    for (unsigned i = 1; i < thread_number; ++i)
+        m_threads.emplace_back(&thread_pool::work, this, i);
+}
+
+inline
+thread_pool::~thread_pool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_start.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+inline unsigned
+thread_pool::size() const noexcept
+{
+    return static_cast<unsigned>(m_threads.size()) + 1;
+}
+
+inline void
+thread_pool::parallel_for(index count, const function_type& fn)
+{
+    if (m_threads.empty() or count <= 1) {
+        for (index i = 0; i < count; ++i)
+            fn(0, i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_count = count;
+        m_chunk = std::max(index{1}, count / (8 * size()));
+        m_next = 0;
+        m_running = static_cast<unsigned>(m_threads.size());
+        ++m_generation;
+    }
+
+    m_start.notify_all();
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_running == 0; });
+    m_fn = nullptr;
+}
+
+inline void
+thread_pool::work(unsigned id) noexcept
+{
+    unsigned long generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation]()
+                         {
+                             return m_stop or m_generation != generation;
+                         });
+
+            if (m_stop)
+                return;
+
+            generation = m_generation;
+        }
+
+        execute(id);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_running == 0)
+                m_done.notify_one();
+        }
+    }
+}
+
+inline void
+thread_pool::execute(unsigned id) noexcept
+{
+    for (;;) {
+        const index begin = m_next.fetch_add(m_chunk);
+        if (begin >= m_count)
+            return;
+
+        const index end = std::min(begin + m_chunk, m_count);
+        for (index i = begin; i != end; ++i)
+            (*m_fn)(id, i);
+    }
+}
+
+} // namespace mitm
+
+#endif
@@ -122,6 +122,12 @@ public:
             mitm::result r = mitm::heuristic_algorithm(
                 state, limit, kappa, delta, theta, std::string{});
 
+            if (r.status != mitm::result_status::success) {
+                std::cout << "no solution founded, " << r.violated
+                          << " constraints violated\n";
+                return false;
+            }
+
             std::cout << "solution founded in " << r.loop << " loops !\n";
             for (mitm::index i = 0; i != n; ++i) {
                 std::cout << r.x[i] << ' ';
@@ -22,8 +22,33 @@
 
 #define CATCH_CONFIG_MAIN
 #include <catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <limits>
+#include <new>
+#include <numeric>
+#include <random>
+#include <tuple>
 #include "matrix.hpp"
+#include "sparse-matrix.hpp"
+#include "penalty-matrix.hpp"
+#include "bit-vector.hpp"
+#include "bit-matrix.hpp"
+#include "kernels.hpp"
+#include "heuristic-classic.hpp"
+#include "thread-pool.hpp"
 #include "io.hpp"
+#include "cstream.hpp"
+#include "text-scanner.hpp"
+#include "text-chunks.hpp"
 
 TEST_CASE("Matrix test", "[matrix]")
 {
@@ -57,3 +82,1805 @@ TEST_CASE("Matrix test", "[matrix]")
     REQUIRE(adapt.cols() == static_cast<std::size_t>(2));
 }
 
+TEST_CASE("Sparse matrix test", "[matrix]")
+{
+    std::vector <int> a { 1, 0, 0, 1,
+                          0, 0, 1, 1,
+                          0, 1, 0, 0 };
+
+    mitm::sparse_matrix <int> s(a, 3, 4);
+
+    REQUIRE(s.rows() == 3);
+    REQUIRE(s.cols() == 4);
+    REQUIRE(s.nonzeros() == 5);
+    REQUIRE(s.row_length(0) == 2);
+    REQUIRE(s.row_length(1) == 2);
+    REQUIRE(s.row_length(2) == 1);
+
+    for (mitm::index k = 0; k != s.rows(); ++k)
+        for (auto pos = s.row_begin(k); pos != s.row_end(k); ++pos)
+            REQUIRE(a[k * 4 + s.column(pos)] == s.value(pos));
+
+    for (mitm::index j = 0; j != s.cols(); ++j) {
+        mitm::index nb = 0;
+        for (auto cpos = s.col_begin(j); cpos != s.col_end(j); ++cpos) {
+            REQUIRE(s.column(s.position(cpos)) == j);
+            REQUIRE(a[s.row(cpos) * 4 + j] == 1);
+            ++nb;
+        }
+
+        REQUIRE(nb == a[j] + a[4 + j] + a[8 + j]);
+    }
+
+    // Attached without values, each row reads as many ones as its length
+    // and no more: the ones are shared by the rows.
+    const std::vector<int> rows_ptr { 0, 1, 4, 6 };
+    const std::vector<int> cols_index { 2, 0, 1, 3, 1, 2 };
+    mitm::sparse_matrix<int, int> attached;
+    attached.attach(3, 4, rows_ptr.data(), cols_index.data(), nullptr);
+
+    REQUIRE(attached.is_attached());
+    REQUIRE(attached.nonzeros() == 6);
+    for (int k = 0; k != attached.rows(); ++k) {
+        const int *values = attached.row_values(k);
+        REQUIRE(std::count(values, values + attached.row_length(k), 1) ==
+                attached.row_length(k));
+    }
+}
+
+TEST_CASE("Partial selection of reduced costs", "[kernels]")
+{
+    using item = std::tuple<mitm::real, mitm::index>;
+
+    std::mt19937 gen(123456);
+    std::uniform_int_distribution<int> dist(-50, 50);
+
+    for (mitm::index size : { 2, 3, 10, 100, 1000 }) {
+        for (mitm::index bk : { 1, 2, 7, 8, 9, 50, 999 }) {
+            if (bk >= size)
+                continue;
+
+            std::vector<item> r;
+            for (mitm::index i = 0; i != size; ++i)
+                r.emplace_back(static_cast<mitm::real>(dist(gen)) / 4, i);
+
+            std::vector<item> sorted(r);
+            std::sort(sorted.begin(), sorted.end(),
+                      [](const item& lhs, const item& rhs)
+                      {
+                          return std::get<0>(lhs) < std::get<0>(rhs);
+                      });
+
+            auto ret = mitm::select_bk(r.begin(), r.end(), bk);
+            REQUIRE(ret.first == std::get<0>(sorted[bk - 1]));
+            REQUIRE(ret.second == std::get<0>(sorted[bk]));
+
+            for (mitm::index i = 0; i != bk; ++i)
+                REQUIRE(std::get<0>(r[i]) <= ret.first);
+            for (mitm::index i = bk; i != size; ++i)
+                REQUIRE(std::get<0>(r[i]) >= ret.first);
+        }
+    }
+}
+
+TEST_CASE("Minimum and second minimum of reduced costs", "[kernels]")
+{
+    std::mt19937 gen(654321);
+    std::uniform_int_distribution<int> dist(-50, 50);
+
+    for (mitm::index size : { 2, 3, 17, 1000 }) {
+        std::vector<mitm::real> v;
+        for (mitm::index i = 0; i != size; ++i)
+            v.emplace_back(static_cast<mitm::real>(dist(gen)) / 4);
+
+        std::vector<mitm::real> sorted(v);
+        std::sort(sorted.begin(), sorted.end());
+
+        auto ret = mitm::select_min2(v.data(), size);
+        REQUIRE(ret.first == sorted[0]);
+        REQUIRE(ret.second == sorted[1]);
+        REQUIRE(v[ret.position] == sorted[0]);
+    }
+}
+
+TEST_CASE("Thread pool parallel for", "[thread]")
+{
+    mitm::thread_pool pool(4);
+    REQUIRE(pool.size() == 4u);
+
+    for (mitm::index count : { 0, 1, 7, 1000 }) {
+        std::vector<int> done(count, 0);
+        std::vector<long> sum(pool.size(), 0);
+
+        pool.parallel_for(count, [&done, &sum](unsigned worker, mitm::index i)
+                          {
+                              done[i]++;
+                              sum[worker] += i;
+                          });
+
+        REQUIRE(std::count(done.cbegin(), done.cend(), 1) == count);
+        REQUIRE(std::accumulate(sum.cbegin(), sum.cend(), 0l) ==
+                count * (count - 1) / 2);
+    }
+}
+
+TEST_CASE("Heuristic stopped by the options", "[heuristic]")
+{
+    // Two incompatible constraints: x0 + x1 + x2 = 1 and x0 + x1 + x2 = 2.
+    mitm::SimpleState s;
+    REQUIRE(s.init(2, 3) == 0);
+    std::fill(s.a.begin(), s.a.end(), true);
+    s.b = { 1, 2 };
+    s.c = { 1, 2, 3 };
+
+    mitm::options o(50);
+    std::vector<mitm::index> loops;
+    o.progress_every = 10;
+    o.progress = [&loops](mitm::index loop, mitm::index violated,
+                          mitm::real)
+        {
+            REQUIRE(violated > 0);
+            loops.emplace_back(loop);
+        };
+
+    auto r = mitm::heuristic_algorithm(s, o);
+    REQUIRE(r.status == mitm::result_status::limit_reached);
+    REQUIRE(r.violated == 1);
+    REQUIRE(r.x.size() == 3u);
+    REQUIRE(loops == std::vector<mitm::index>({ 9, 19, 29, 39, 49 }));
+
+    o.progress = nullptr;
+    o.limit = std::numeric_limits<mitm::index>::max();
+    o.time_limit(std::chrono::milliseconds(10));
+    r = mitm::heuristic_algorithm(s, o);
+    REQUIRE(r.status == mitm::result_status::time_limit);
+
+    o.deadline = mitm::options::clock::time_point::max();
+    auto future = mitm::heuristic_algorithm_async(s, o);
+    o.token.cancel();
+    r = future.get();
+    REQUIRE(r.status == mitm::result_status::cancelled);
+    REQUIRE(r.violated >= 1);
+}
+
+TEST_CASE("Gpgpu method result", "[heuristic]")
+{
+    mitm::SimpleState s;
+    REQUIRE(s.init(2, 3) == 0);
+    s.a = { 1, 0, 0, 1, 1, 1 };
+    s.b = { 1, 1 };
+    s.c = { 27.3f, 48.1f, 0.19f };
+
+    // Without CUDA, the result is the x = 0 assignment.
+    const mitm::result r = mitm::heuristic_algorithm(
+        s, mitm::options(10, mitm::parameters(), "gpgpu"));
+    REQUIRE(r.x.size() == 3u);
+    REQUIRE(r.violated <= 2);
+}
+
+TEST_CASE("Rows selecting none or all of their variables", "[heuristic]")
+{
+    // The example of mitm -h: the row 0 has one variable and b = 1.
+    mitm::SimpleState s;
+    REQUIRE(s.init(2, 3) == 0);
+    s.a = { 1, 0, 0, 1, 1, 1 };
+    s.b = { 1, 1 };
+    s.c = { 27.3f, 48.1f, 0.19f };
+
+    // x1 + x2 = 0 and x0 + x1 = 1, the negative cost sets x2 at start.
+    mitm::SimpleState zero;
+    REQUIRE(zero.init(2, 3) == 0);
+    zero.a = { 0, 1, 1, 1, 1, 0 };
+    zero.b = { 0, 1 };
+    zero.c = { 3, 1, -2 };
+
+    for (const char *impl : { "", "parallel" }) {
+        const mitm::options o(100, mitm::parameters(), impl);
+
+        const mitm::result r = mitm::heuristic_algorithm(s, o);
+        REQUIRE(r.status == mitm::result_status::success);
+        REQUIRE(r.x == std::vector<bool>({ 1, 0, 0 }));
+
+        const mitm::result z = mitm::heuristic_algorithm(zero, o);
+        REQUIRE(z.status == mitm::result_status::success);
+        REQUIRE(z.x == std::vector<bool>({ 1, 0, 0 }));
+    }
+}
+
+TEST_CASE("Kappa above the default kappa_max", "[heuristic]")
+{
+    // x0 + x1 = 1 and x1 + x2 = 1.
+    mitm::SimpleState s;
+    REQUIRE(s.init(2, 3) == 0);
+    s.a = { 1, 1, 0, 0, 1, 1 };
+    s.b = { 1, 1 };
+    s.c = { 3, 1, 3 };
+
+    // x0 + x1 <= 1 and x1 + x2 <= 1 for the negative coefficient engine.
+    mitm::NegativeCoefficient neg;
+    neg.init(2, 3);
+    neg.a = { 1, 1, 0, 0, 1, 1 };
+    neg.b = { { 0, 1 }, { 0, 1 } };
+    neg.c = { 3, 1, 3 };
+
+    const mitm::parameters p(0.95, 0.01, 0.5, mitm::schedule::constant);
+    REQUIRE(p.kappa > p.kappa_max);
+
+    for (const char *impl : { "", "parallel" }) {
+        mitm::result r = mitm::heuristic_algorithm(s, 100, p, impl);
+        REQUIRE(r.status == mitm::result_status::success);
+        REQUIRE(r.x == std::vector<bool>({ 0, 1, 0 }));
+
+        r = mitm::heuristic_algorithm(s, 100, 0.95, 0.01, 0.5, impl);
+        REQUIRE(r.status == mitm::result_status::success);
+        REQUIRE(r.x == std::vector<bool>({ 0, 1, 0 }));
+    }
+
+    mitm::result r = mitm::heuristic_algorithm(neg, 100, p, "");
+    REQUIRE(r.status == mitm::result_status::success);
+    REQUIRE(r.x == std::vector<bool>({ 0, 0, 0 }));
+
+    r = mitm::heuristic_algorithm(neg, 100, 0.95, 0.01, 0.5, "");
+    REQUIRE(r.status == mitm::result_status::success);
+
+    // kappa_max still bounds the schedules which raise kappa.
+    REQUIRE_THROWS(mitm::heuristic_algorithm(
+                       s, 100, mitm::parameters(0.5, 0.01, 0.5,
+                                                mitm::schedule::geometric,
+                                                0.1, 1), ""));
+}
+
+TEST_CASE("Negative coefficients without solution", "[heuristic]")
+{
+    // x0 - x1 + x2 in [-2, 0], -x0 - x1 = -2 and x0 + x1 + x2 in [-1, 1]:
+    // the second row sets x0 and x1 and violates the third one.
+    mitm::NegativeCoefficient s;
+    s.init(3, 3);
+    s.a = { 1, -1, 1, -1, -1, 0, 1, 1, 1 };
+    s.b = { { -2, 0 }, { -2, -2 }, { -1, 1 } };
+    s.c = { 0, -3, 0 };
+
+    const mitm::result r = mitm::heuristic_algorithm(s, 50,
+                                                     mitm::parameters(), "");
+    REQUIRE(r.status == mitm::result_status::limit_reached);
+    REQUIRE(r.x.size() == 3u);
+
+    // The best assignment is returned with its own violated rows and value.
+    mitm::index violated = 0;
+    for (std::size_t k = 0; k != s.b.size(); ++k) {
+        int ax = 0;
+        for (std::size_t j = 0; j != s.c.size(); ++j)
+            ax += s.a[k * s.c.size() + j] * r.x[j];
+
+        if (ax < s.b[k].lower_bound or ax > s.b[k].upper_bound)
+            ++violated;
+    }
+
+    mitm::real value = 0;
+    for (std::size_t j = 0; j != s.c.size(); ++j)
+        value += s.c[j] * r.x[j];
+
+    REQUIRE(r.violated >= 1);
+    REQUIRE(r.violated == violated);
+    REQUIRE(r.value == value);
+}
+
+TEST_CASE("Negative coefficients solved in one loop", "[heuristic]")
+{
+    // x0 + x1 = 1 and x2 - x3 in [0, 1]: the first sweep updates the row 0
+    // and satisfies every row, the success is reported on the first loop.
+    mitm::NegativeCoefficient s;
+    s.init(2, 4);
+    s.a = { 1, 1, 0, 0, 0, 0, 1, -1 };
+    s.b = { { 1, 1 }, { 0, 1 } };
+    s.c = { 1, 2, 1, 1 };
+
+    const mitm::result r = mitm::heuristic_algorithm(s, 10,
+                                                     mitm::parameters(), "");
+    REQUIRE(r.status == mitm::result_status::success);
+    REQUIRE(r.loop == 0);
+    REQUIRE(r.violated == 0);
+    REQUIRE(r.x == std::vector<bool>({ 1, 0, 0, 0 }));
+}
+
+namespace {
+
+// The operator new calls of the tests, a std::vector grows or shrinks
+// through it, Eigen uses std::malloc.
+std::atomic<unsigned long> allocations(0);
+
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocations;
+
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* ptr = operator new(size, std::nothrow))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+TEST_CASE("Solver reuses its buffers", "[heuristic]")
+{
+    // Assignment problems of decreasing then increasing sizes, in CSR.
+    struct assignment
+    {
+        std::vector<mitm::index> rows_ptr, cols_index;
+        std::vector<int> b;
+        std::vector<mitm::real> c;
+
+        explicit assignment(mitm::index size)
+            : rows_ptr(1, 0)
+            , b(2 * size, 1)
+            , c(size * size)
+        {
+            for (mitm::index i = 0; i != size; ++i) {
+                for (mitm::index j = 0; j != size; ++j) {
+                    cols_index.emplace_back(i * size + j);
+                    c[i * size + j] =
+                        static_cast<mitm::real>((5 * i + 3 * j) % 16);
+                }
+                rows_ptr.emplace_back(cols_index.size());
+            }
+
+            for (mitm::index j = 0; j != size; ++j) {
+                for (mitm::index i = 0; i != size; ++i)
+                    cols_index.emplace_back(i * size + j);
+                rows_ptr.emplace_back(cols_index.size());
+            }
+        }
+
+        mitm::csr_view view() const
+        {
+            return { static_cast<mitm::index>(b.size()),
+                     static_cast<mitm::index>(c.size()), rows_ptr.data(),
+                     cols_index.data(), nullptr, b.data(), c.data() };
+        }
+    };
+
+    const mitm::options o(100, mitm::parameters(0.1, 0.01, 0.5));
+    mitm::solver solver;
+    bool first = true;
+
+    for (mitm::index n : { 6, 4, 3, 6 }) {
+        const assignment model(n);
+        const auto expected = mitm::heuristic_algorithm(model.view(), o);
+        std::vector<std::uint8_t> x(model.c.size());
+
+        // Only the first solve() allocates the std::vector buffers.
+        const unsigned long before = allocations;
+        const auto r = solver.solve(model.view(), o, x.data());
+        if (not first)
+            REQUIRE(allocations == before);
+        first = false;
+
+        REQUIRE(r.status == expected.status);
+        REQUIRE(r.loop == expected.loop);
+        REQUIRE(r.violated == expected.violated);
+        REQUIRE(r.value == expected.value);
+        REQUIRE(std::equal(x.cbegin(), x.cend(), expected.x.cbegin()));
+    }
+
+    // The Eigen vectors keep their buffers with fewer rows and columns.
+    using heuristic = mitm::classic::wedelin_heuristic<mitm::real,
+                                                       mitm::index>;
+
+    const assignment large(6), small(3);
+    heuristic wh(large.view(), o.p);
+    const auto data = std::make_tuple(wh.b.data(), wh.c.data(), wh.pi.data(),
+                                      wh.u.data(), wh.activity.ax.data());
+
+    wh.init(small.view(), o.p);
+    REQUIRE(data == std::make_tuple(wh.b.data(), wh.c.data(), wh.pi.data(),
+                                    wh.u.data(), wh.activity.ax.data()));
+}
+
+template <typename Index>
+void check_csr_view(const mitm::SimpleState& s, const mitm::options& o,
+                    const mitm::result& expected, bool values)
+{
+    const Index m = static_cast<Index>(s.b.size());
+    const Index n = static_cast<Index>(s.c.size());
+    std::vector<Index> rows_ptr(1, 0), cols_index;
+    std::vector<int> coefficients;
+
+    for (Index i = 0; i != m; ++i) {
+        for (Index j = 0; j != n; ++j) {
+            if (s.a[i * n + j]) {
+                cols_index.emplace_back(j);
+                coefficients.emplace_back(1);
+            }
+        }
+
+        rows_ptr.emplace_back(static_cast<Index>(cols_index.size()));
+    }
+
+    const mitm::basic_csr_view<Index> model {
+        m, n, rows_ptr.data(), cols_index.data(),
+        values ? coefficients.data() : nullptr, s.b.data(), s.c.data() };
+
+    mitm::solver solver;
+    std::vector<std::uint8_t> x(n, 2);
+    const auto r = solver.solve(model, o, x.data());
+
+    REQUIRE(r.status == expected.status);
+    REQUIRE(r.loop == expected.loop);
+    REQUIRE(r.value == expected.value);
+    for (Index j = 0; j != n; ++j)
+        REQUIRE(x[j] == (expected.x[j] ? 1 : 0));
+
+    std::vector<Index> columns;
+    const auto q = solver.solve(model, o, columns);
+
+    REQUIRE(q.status == expected.status);
+    REQUIRE(q.loop == expected.loop);
+    REQUIRE(static_cast<std::size_t>(std::count(expected.x.cbegin(),
+                                                expected.x.cend(), true)) ==
+            columns.size());
+    for (auto j : columns)
+        REQUIRE(expected.x[j]);
+
+    // A column repeated in a row is refused.
+    cols_index[1] = cols_index[0];
+    REQUIRE_THROWS(solver.solve(model, o, x.data()));
+}
+
+TEST_CASE("Solver on the CSR arrays of the caller", "[heuristic]")
+{
+    const int size = 5;
+    mitm::SimpleState s;
+    REQUIRE(s.init(2 * size, size * size) == 0);
+
+    for (int i = 0; i != size; ++i) {
+        for (int j = 0; j != size; ++j) {
+            s.a[i * size * size + i * size + j] = true;
+            s.a[(size + j) * size * size + i * size + j] = true;
+            s.c[i * size + j] = static_cast<mitm::real>((7 * i + 3 * j) % 11);
+        }
+    }
+
+    std::fill(s.b.begin(), s.b.end(), 1);
+
+    const mitm::options o(100, mitm::parameters(0.1, 0.01, 0.5));
+    const auto expected = mitm::heuristic_algorithm(s, o);
+
+    check_csr_view<std::int32_t>(s, o, expected, true);
+    check_csr_view<std::int32_t>(s, o, expected, false);
+    check_csr_view<std::int64_t>(s, o, expected, true);
+
+    // heuristic_algorithm runs the std::int32_t engine on a copy of the
+    // arrays of the view, a column out of range is not wrapped around.
+    const mitm::index n = static_cast<mitm::index>(s.c.size());
+    std::vector<mitm::index> rows_ptr(1, 0), cols_index;
+    for (mitm::index i = 0; i != static_cast<mitm::index>(s.b.size()); ++i) {
+        for (mitm::index j = 0; j != n; ++j)
+            if (s.a[i * n + j])
+                cols_index.emplace_back(j);
+
+        rows_ptr.emplace_back(static_cast<mitm::index>(cols_index.size()));
+    }
+
+    const mitm::csr_view view {
+        static_cast<mitm::index>(s.b.size()), n, rows_ptr.data(),
+        cols_index.data(), nullptr, s.b.data(), s.c.data() };
+
+    const auto r = mitm::heuristic_algorithm(view, o);
+    REQUIRE(r.status == expected.status);
+    REQUIRE(r.loop == expected.loop);
+    REQUIRE(r.x == expected.x);
+
+    if (sizeof(mitm::index) > sizeof(std::int32_t)) {
+        cols_index[0] += std::numeric_limits<std::uint32_t>::max() + 1ll;
+        REQUIRE_THROWS(mitm::heuristic_algorithm(view, o));
+    }
+}
+
+/// A random m x n model in CSR form with 0/1 or -1, 1 and 2 coefficients
+/// and b the activities of a random assignment.
+struct random_csr_model
+{
+    std::vector<mitm::index> rows_ptr, cols_index;
+    std::vector<int> values, b;
+    std::vector<mitm::real> c;
+
+    random_csr_model(mitm::index m, mitm::index n, unsigned seed,
+                     bool binary = false)
+        : rows_ptr(1, 0)
+    {
+        std::mt19937 gen(seed);
+        std::bernoulli_distribution nonzero(0.2);
+        std::bernoulli_distribution solution(0.3);
+        std::uniform_int_distribution<int> coefficient(0, 3);
+        std::uniform_int_distribution<int> cost(-5, 20);
+
+        std::vector<int> x(n);
+        for (auto& elem : x)
+            elem = solution(gen);
+
+        for (mitm::index k = 0; k != m; ++k) {
+            int ax = 0;
+
+            for (mitm::index j = 0; j != n; ++j) {
+                if (nonzero(gen)) {
+                    const int a = coefficient(gen);
+                    cols_index.emplace_back(j);
+                    values.emplace_back(binary ? 1 : a == 0 ? -1 :
+                                        a == 3 ? 1 : a);
+                    ax += values.back() * x[j];
+                }
+            }
+
+            rows_ptr.emplace_back(static_cast<mitm::index>(
+                                      cols_index.size()));
+            b.emplace_back(ax);
+        }
+
+        for (mitm::index j = 0; j != n; ++j)
+            c.emplace_back(static_cast<mitm::real>(cost(gen)));
+    }
+
+    mitm::csr_view view() const
+    {
+        return { static_cast<mitm::index>(b.size()),
+                 static_cast<mitm::index>(c.size()), rows_ptr.data(),
+                 cols_index.data(), values.data(), b.data(), c.data() };
+    }
+};
+
+TEST_CASE("Incremental row activities", "[heuristic]")
+{
+    using heuristic = mitm::classic::wedelin_heuristic<mitm::real,
+                                                       mitm::index>;
+
+    const random_csr_model model(40, 60, 2002);
+    heuristic wh(model.view(), mitm::parameters(0.1, 0.01, 0.5));
+
+    // The violated rows and the objective computed from scratch.
+    auto check = [&wh]()
+        {
+            REQUIRE(wh.activity.check(*wh.A, wh.b, wh.x));
+
+            mitm::index violated = 0;
+            for (mitm::index k = 0; k != wh.m; ++k)
+                if (wh.activity.compute(*wh.A, wh.x, k) != wh.b(k))
+                    ++violated;
+            REQUIRE(wh.activity.violated() == violated);
+
+            mitm::real objective = 0;
+            for (mitm::index j = 0; j != wh.n; ++j)
+                objective += wh.c(j) * wh.x[j];
+            REQUIRE(wh.objective == Approx(objective));
+        };
+
+    check();
+
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<mitm::index> variable(0, wh.n - 1);
+    std::bernoulli_distribution value(0.5);
+
+    for (int flip = 0; flip != 500; ++flip) {
+        std::vector<mitm::index> violated;
+        wh.assign(variable(gen), value(gen),
+                  [&violated](mitm::index h) { violated.emplace_back(h); });
+
+        // Only the rows which become violated are reported.
+        for (mitm::index h : violated)
+            REQUIRE(wh.activity.is_violated(h, wh.b));
+
+        check();
+    }
+
+    for (int loop = 0; loop != 10; ++loop) {
+        wh.next();
+        check();
+    }
+}
+
+TEST_CASE("Incremental reduced costs aggregate", "[heuristic]")
+{
+    using heuristic = mitm::classic::wedelin_heuristic<mitm::real,
+                                                       mitm::index>;
+
+    // With 0/1 coefficients pi and u remain bounded, the float rounding of
+    // the incremental updates too.
+    const random_csr_model model(40, 60, 2003, true);
+
+    for (mitm::real theta : { 0.0f, 0.5f, 1.0f }) {
+        heuristic wh(model.view(), mitm::parameters(0.1, 0.01, theta));
+        const auto& A = *wh.A;
+
+        for (int loop = 0; loop != 20; ++loop) {
+            wh.next();
+
+            // u(j) is sum_h a_hj (pi_h + P_hj) over the column j of A.
+            for (mitm::index j = 0; j != wh.n; ++j) {
+                mitm::real u = 0;
+                for (auto cpos = A.col_begin(j), end = A.col_end(j);
+                     cpos != end; ++cpos) {
+                    const mitm::index h = A.row(cpos);
+                    const mitm::index pos = A.position(cpos);
+
+                    u += A.value(pos) * (wh.pi(h) + wh.P(h, pos));
+                }
+
+                REQUIRE(wh.u(j) == Approx(u).margin(1e-3));
+            }
+        }
+    }
+}
+
+TEST_CASE("Constraint arena layout", "[heuristic]")
+{
+    using heuristic = mitm::classic::wedelin_heuristic<mitm::real,
+                                                       mitm::index>;
+
+    // Rows of 2 to 4 variables, b = 1 makes set partitioning rows.
+    std::mt19937 gen(2013);
+    std::uniform_int_distribution<mitm::index> length(2, 4);
+    std::uniform_int_distribution<int> rhs(0, 2);
+    const mitm::index m = 30, n = 20;
+    std::vector<mitm::index> rows_ptr(1, 0), cols_index;
+    std::vector<int> values, b;
+    std::vector<mitm::real> c;
+
+    for (mitm::index k = 0; k != m; ++k) {
+        const mitm::index first = k % (n - 4);
+        for (mitm::index i = 0, e = length(gen); i != e; ++i) {
+            cols_index.emplace_back(first + i);
+            values.emplace_back(k % 5 == 4 ? 2 : 1);
+        }
+
+        rows_ptr.emplace_back(static_cast<mitm::index>(cols_index.size()));
+        b.emplace_back(rhs(gen));
+    }
+
+    for (mitm::index j = 0; j != n; ++j)
+        c.emplace_back(static_cast<mitm::real>((7 * j) % 5));
+
+    const mitm::csr_view model { m, n, rows_ptr.data(), cols_index.data(),
+                                 values.data(), b.data(), c.data() };
+    const mitm::real theta = 0.5;
+    heuristic wh(model, mitm::parameters(0.1, 0.01, theta));
+    const auto& A = *wh.A;
+
+    // The reduced costs follow the CSR positions of A, the scratch buffers
+    // of the other rows follow each other in the order of the rows.
+    REQUIRE(wh.arena.values.size() ==
+            static_cast<std::size_t>(A.nonzeros()));
+
+    mitm::index scratch = 0, partitioning = 0;
+    for (mitm::index k = 0; k != m; ++k) {
+        const auto& constraint = wh.constraints[k];
+
+        REQUIRE(constraint.k == k);
+        REQUIRE(constraint.length == A.row_length(k));
+        REQUIRE(constraint.set_partitioning ==
+                (b[k] == 1 and k % 5 != 4));
+
+        if (constraint.set_partitioning) {
+            ++partitioning;
+        } else {
+            REQUIRE(constraint.offset == scratch);
+            scratch += constraint.length;
+        }
+    }
+
+    REQUIRE(partitioning > 0);
+    REQUIRE(partitioning < m);
+    REQUIRE(wh.arena.scratch.size() == static_cast<std::size_t>(scratch));
+
+    // Each update writes the reduced costs of its row at the CSR positions
+    // of the row: c_j - sum_h a_hj (pi_h + P_hj) with P_kj decayed.
+    auto assign = [&wh](mitm::index j, int value)
+        {
+            wh.assign(j, value, [](mitm::index) {});
+        };
+
+    for (int loop = 0; loop != 5; ++loop) {
+        for (mitm::index k = 0; k != m; ++k) {
+            std::vector<mitm::real> expected;
+            for (auto pos = A.row_begin(k); pos != A.row_end(k); ++pos) {
+                const mitm::index j = A.column(pos);
+                mitm::real r = wh.c(j) +
+                    A.value(pos) * (1 - theta) * wh.P(k, pos);
+
+                for (auto cpos = A.col_begin(j), end = A.col_end(j);
+                     cpos != end; ++cpos)
+                    r -= A.value(A.position(cpos)) *
+                        (wh.pi(A.row(cpos)) +
+                         wh.P(A.row(cpos), A.position(cpos)));
+
+                expected.emplace_back(r);
+            }
+
+            wh.constraints[k].update(A, wh.arena, wh.c, wh.P, wh.pi, wh.u,
+                                     assign, wh.p.kappa, wh.p.delta,
+                                     wh.p.theta);
+
+            for (mitm::index i = 0; i != A.row_length(k); ++i)
+                REQUIRE(wh.arena.values[A.row_begin(k) + i] ==
+                        Approx(expected[i]).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Penalty matrix with lazy row scale", "[penalty]")
+{
+    std::mt19937 gen(1234);
+    std::bernoulli_distribution nonzero(0.4);
+    std::uniform_real_distribution<mitm::real> value(-1, 1);
+    std::uniform_int_distribution<int> action(0, 3);
+
+    const mitm::index m = 7, n = 11;
+    std::vector<int> dense(m * n);
+    for (auto& elem : dense)
+        elem = nonzero(gen);
+
+    mitm::sparse_matrix<int> A(dense, m, n);
+    mitm::penalty_matrix P(A);
+    std::vector<mitm::real> reference(A.nonzeros(), 0);
+
+    REQUIRE(P.rows() == m);
+    REQUIRE(P.nonzeros() == A.nonzeros());
+
+    for (int it = 0; it != 2000; ++it) {
+        std::uniform_int_distribution<mitm::index> row(0, m - 1);
+        const mitm::index k = row(gen);
+
+        switch (action(gen)) {
+        case 0:
+            // theta = 0 and tiny theta force the renormalization.
+            for (auto theta : { mitm::real(0.5), mitm::real(1e-12),
+                                mitm::real(0) }) {
+                P.scale(k, theta);
+                for (auto pos = A.row_begin(k); pos != A.row_end(k); ++pos)
+                    reference[pos] *= theta;
+                if (value(gen) < 0.9)
+                    break;
+            }
+            break;
+        case 1:
+            for (auto pos = A.row_begin(k); pos != A.row_end(k); ++pos) {
+                const mitm::real d = value(gen);
+                P.add(k, pos, d);
+                reference[pos] += d;
+            }
+            break;
+        case 2:
+            P.scale(k, mitm::real(0.9));
+            for (auto pos = A.row_begin(k); pos != A.row_end(k); ++pos)
+                reference[pos] *= mitm::real(0.9);
+            break;
+        default:
+            for (auto pos = A.row_begin(k); pos != A.row_end(k); ++pos) {
+                const mitm::real d = value(gen);
+                P.set(k, pos, d);
+                reference[pos] = d;
+            }
+        }
+
+        for (mitm::index h = 0; h != m; ++h)
+            for (auto pos = A.row_begin(h); pos != A.row_end(h); ++pos)
+                REQUIRE(P(h, pos) ==
+                        Approx(reference[pos]).margin(1e-5).epsilon(1e-4));
+    }
+}
+
+template <typename Index>
+void check_kernels()
+{
+    std::mt19937 gen(98765);
+    std::uniform_int_distribution<int> dist(-40, 40);
+    const auto available = mitm::available_kernels<mitm::real, Index>();
+    const auto& scalar = *available.front();
+
+    REQUIRE(std::string(scalar.name) == "scalar");
+
+    for (Index size : { 2, 7, 8, 15, 16, 33, 100, 1001 }) {
+        const Index n = 2 * size;
+        std::vector<Index> I(n);
+        std::iota(I.begin(), I.end(), 0);
+        std::shuffle(I.begin(), I.end(), gen);
+        I.resize(size);
+
+        std::vector<mitm::real> c(n), u(n), p(size);
+        std::vector<int> a(size);
+        for (auto& elem : c)
+            elem = static_cast<mitm::real>(dist(gen)) / 8;
+        for (auto& elem : u)
+            elem = static_cast<mitm::real>(dist(gen)) / 8;
+        for (auto& elem : p)
+            elem = static_cast<mitm::real>(dist(gen)) / 8;
+        for (auto& elem : a)
+            elem = dist(gen) < 0 ? -1 : 1;
+
+        std::vector<mitm::real> ref_u(u), ref_p(p), ref_out(size);
+        scalar.reduced_costs(c.data(), ref_u.data(), I.data(), a.data(),
+                             p.data(), -0.5, ref_out.data(), size);
+        const auto ref_min = scalar.select_min2(ref_out.data(), size);
+        const auto ref_count = scalar.count_less(ref_out.data(), size,
+                                                 ref_out[size / 2]);
+        scalar.add_row(ref_p.data(), 0.25, ref_u.data(), I.data(),
+                       a.data(), 0.75, size);
+
+        for (auto kernel : available) {
+            std::vector<mitm::real> k_u(u), k_p(p), k_out(size);
+            kernel->reduced_costs(c.data(), k_u.data(), I.data(), a.data(),
+                                  p.data(), -0.5, k_out.data(), size);
+
+            for (Index i = 0; i != size; ++i)
+                REQUIRE(k_out[i] == Approx(ref_out[i]));
+
+            const auto k_min = kernel->select_min2(ref_out.data(), size);
+            REQUIRE(k_min.first == ref_min.first);
+            REQUIRE(k_min.second == ref_min.second);
+            REQUIRE(k_min.position == ref_min.position);
+            REQUIRE(kernel->count_less(ref_out.data(), size,
+                                       ref_out[size / 2]) == ref_count);
+
+            kernel->add_row(k_p.data(), 0.25, k_u.data(), I.data(),
+                            a.data(), 0.75, size);
+
+            for (Index i = 0; i != size; ++i)
+                REQUIRE(k_p[i] == Approx(ref_p[i]));
+            for (Index j = 0; j != n; ++j)
+                REQUIRE(k_u[j] == Approx(ref_u[j]));
+        }
+    }
+}
+
+TEST_CASE("Constraint kernels of all instruction sets", "[kernels]")
+{
+    check_kernels<std::int64_t>();
+    check_kernels<std::int32_t>();
+}
+
+TEST_CASE("Parallel worklist sweep", "[heuristic]")
+{
+    using heuristic = mitm::classic::parallel_wedelin_heuristic<mitm::real,
+                                                                mitm::index>;
+
+    const int size = 10;
+    mitm::SimpleState s;
+    REQUIRE(s.init(2 * size, size * size) == 0);
+
+    for (int i = 0; i != size; ++i) {
+        for (int j = 0; j != size; ++j) {
+            s.a[i * size * size + i * size + j] = true;
+            s.a[(size + j) * size * size + i * size + j] = true;
+            s.c[i * size + j] = static_cast<mitm::real>((7 * i + 3 * j) % 13);
+        }
+    }
+
+    std::fill(s.b.begin(), s.b.end(), 1);
+
+    // Run the parallel heuristic until a solution, returns the loops.
+    auto run = [&s](heuristic& wh)
+        {
+            int loop = 0;
+            while (not wh.next() and loop != 1000)
+                ++loop;
+
+            REQUIRE(wh.activity.violated() == 0);
+            REQUIRE(wh.activity.check(*wh.A, wh.b, wh.x));
+            return loop;
+        };
+
+    mitm::parameters p(0.1, 0.01, 0.5);
+    heuristic all(s, p, 2);
+    run(all);
+
+    p.order = mitm::sweep::worklist;
+    heuristic worklist(s, p, 2);
+    const int loops = run(worklist);
+    REQUIRE(loops > 0);
+    REQUIRE(worklist.visited < all.visited);
+
+    // The same loops with any number of threads, sweep::violation is the
+    // same sweep.
+    for (auto order : { mitm::sweep::worklist, mitm::sweep::violation }) {
+        p.order = order;
+        heuristic other(s, p, 3);
+        REQUIRE(run(other) == loops);
+        REQUIRE(other.visited == worklist.visited);
+        for (mitm::index j = 0; j != other.n; ++j)
+            REQUIRE(other.x[j] == worklist.x[j]);
+    }
+
+    const mitm::result r = mitm::heuristic_algorithm(
+        s, mitm::options(1000, p, "parallel"));
+    REQUIRE(r.status == mitm::result_status::success);
+}
+
+TEST_CASE("Portfolio of shuffled worklist sweeps", "[heuristic]")
+{
+    using heuristic = mitm::classic::wedelin_heuristic<mitm::real,
+                                                       mitm::index>;
+
+    const int size = 10;
+    mitm::SimpleState s;
+    REQUIRE(s.init(2 * size, size * size) == 0);
+
+    for (int i = 0; i != size; ++i) {
+        for (int j = 0; j != size; ++j) {
+            s.a[i * size * size + i * size + j] = true;
+            s.a[(size + j) * size * size + i * size + j] = true;
+            s.c[i * size + j] =
+                static_cast<mitm::real>((5 * i + 3 * j + i * j) % 13);
+        }
+    }
+
+    std::fill(s.b.begin(), s.b.end(), 1);
+
+    // The first two instances only differ by the shuffled order of the
+    // constraints.
+    std::vector<mitm::parameters> portfolio = {
+        mitm::parameters(0.1, 0.01, 0.5), mitm::parameters(0.1, 0.01, 0.5),
+        mitm::parameters(0.3, 0.05, 0.2), mitm::parameters(0.01, 0.001, 0.9),
+        mitm::parameters(0.5, 0.1, 0.1)
+    };
+
+    for (auto& p : portfolio)
+        p.order = mitm::sweep::worklist;
+
+    // The constraints visited and the cost of each instance run alone. An
+    // instance sharing the matrix of the first one runs the same sweeps.
+    const mitm::index limit = 1000;
+    const heuristic first(s, portfolio[0]);
+    std::vector<unsigned long> visited;
+    std::vector<mitm::real> values;
+    for (std::size_t i = 0; i != portfolio.size(); ++i) {
+        heuristic wh(s, portfolio[i]);
+        heuristic shared(first, portfolio[i]);
+        REQUIRE(shared.A == first.A);
+
+        for (heuristic *elem : { &wh, &shared }) {
+            if (i > 0)
+                elem->shuffle(static_cast<unsigned>(i));
+
+            mitm::index loop = 0;
+            while (not elem->next() and loop != limit)
+                ++loop;
+
+            REQUIRE(loop != limit);
+        }
+
+        REQUIRE(shared.visited == wh.visited);
+        REQUIRE(shared.value() == wh.value());
+        visited.emplace_back(wh.visited);
+        values.emplace_back(wh.value());
+
+        // A new model does not modify the shared matrix.
+        shared.init(s, 2 * size, size * size, portfolio[i]);
+        REQUIRE(shared.A != first.A);
+        REQUIRE(first.A.use_count() == 1);
+    }
+
+    REQUIRE(visited[0] != visited[1]);
+
+    const mitm::real lowest = *std::min_element(values.cbegin(),
+                                                values.cend());
+    REQUIRE(lowest != *std::max_element(values.cbegin(), values.cend()));
+
+    // All the instances run to their solution, the cheapest one is returned.
+    mitm::result r = mitm::heuristic_algorithm(s, limit, portfolio, 2, false);
+    REQUIRE(r.status == mitm::result_status::success);
+    REQUIRE(r.value == lowest);
+
+    // The first solutions stop the others, one of them is returned.
+    r = mitm::heuristic_algorithm(s, limit, portfolio, 2, true);
+    REQUIRE(r.status == mitm::result_status::success);
+    REQUIRE(std::find(values.cbegin(), values.cend(), r.value) !=
+            values.cend());
+
+    // Without solution, the token stops all the instances: the callback of
+    // the first one cancels the run.
+    mitm::SimpleState none;
+    REQUIRE(none.init(2, 3) == 0);
+    std::fill(none.a.begin(), none.a.end(), true);
+    none.b = { 1, 2 };
+    none.c = { 1, 2, 3 };
+
+    for (bool first_solution : { false, true }) {
+        mitm::options o(std::numeric_limits<mitm::index>::max());
+        o.progress = [&o](mitm::index loop, mitm::index, mitm::real)
+            {
+                if (loop == 10)
+                    o.token.cancel();
+            };
+
+        r = mitm::heuristic_algorithm(none, o, portfolio, 2, first_solution);
+        REQUIRE(r.status == mitm::result_status::cancelled);
+        REQUIRE(r.violated == 1);
+    }
+}
+
+TEST_CASE("Heuristic with all the real and index types", "[heuristic]")
+{
+    // A 4 x 4 assignment problem: each row and each column of the 0/1
+    // matrix X is assigned once, c is the cost of X.
+    const int size = 4;
+    mitm::SimpleState s;
+    REQUIRE(s.init(2 * size, size * size) == 0);
+
+    for (int i = 0; i != size; ++i) {
+        for (int j = 0; j != size; ++j) {
+            s.a[i * size * size + i * size + j] = true;
+            s.a[(size + j) * size * size + i * size + j] = true;
+            s.c[i * size + j] = static_cast<mitm::real>((5 * i + 3 * j) % 16);
+        }
+    }
+
+    std::fill(s.b.begin(), s.b.end(), 1);
+
+    const mitm::options o(100, mitm::parameters(0.1, 0.01, 0.5));
+    const mitm::result results[] = {
+        mitm::heuristic_algorithm<float, std::int32_t>(s, o),
+        mitm::heuristic_algorithm<float, std::int64_t>(s, o),
+        mitm::heuristic_algorithm<double, std::int32_t>(s, o),
+        mitm::heuristic_algorithm<double, std::int64_t>(s, o)
+    };
+
+    for (const auto& r : results) {
+        REQUIRE(r.status == mitm::result_status::success);
+        REQUIRE(r.violated == 0);
+        REQUIRE(std::count(r.x.cbegin(), r.x.cend(), true) == size);
+    }
+
+    // The index type does not change the arithmetic.
+    REQUIRE(results[0].x == results[1].x);
+    REQUIRE(results[0].loop == results[1].loop);
+    REQUIRE(results[2].x == results[3].x);
+    REQUIRE(results[2].loop == results[3].loop);
+}
+
+TEST_CASE("Bit-packed vector and matrix", "[bit]")
+{
+    std::mt19937 gen(4242);
+    std::bernoulli_distribution bit(0.3);
+
+    for (mitm::index n : { 1, 63, 64, 65, 200 }) {
+        const mitm::index m = 5;
+        std::vector<int> dense(m * n), values(n);
+        for (auto& elem : dense)
+            elem = bit(gen);
+
+        mitm::bit_vector x(n);
+        REQUIRE(x.length() == n);
+        REQUIRE(x.count() == 0);
+
+        for (mitm::index j = 0; j != n; ++j) {
+            values[j] = bit(gen);
+            x.set(j, values[j]);
+        }
+
+        std::vector<mitm::index> set;
+        x.for_each([&set](mitm::index j) { set.emplace_back(j); });
+        REQUIRE(static_cast<mitm::index>(set.size()) == x.count());
+
+        for (mitm::index j = 0; j != n; ++j) {
+            REQUIRE(x[j] == values[j]);
+            REQUIRE(std::binary_search(set.cbegin(), set.cend(), j) ==
+                    (values[j] == 1));
+        }
+
+        // The popcount activities are the CSR ones, the activities of
+        // row_activity use the bit rows of a dense 0/1 matrix.
+        const mitm::sparse_matrix<int> A(dense, m, n);
+        const mitm::bit_matrix B(A);
+        REQUIRE(B.rows() == m);
+
+        mitm::classic::row_activity<mitm::index> activity;
+        activity.init(A, Eigen::VectorXi::Zero(m), x);
+        REQUIRE(activity.rows.empty() == not mitm::bit_matrix::is_smaller(A));
+
+        for (mitm::index k = 0; k != m; ++k) {
+            int ax = 0;
+            for (mitm::index pos = A.row_begin(k), end = A.row_end(k);
+                 pos != end; ++pos)
+                ax += A.value(pos) * values[A.column(pos)];
+
+            REQUIRE(B.dot(k, x) == ax);
+            REQUIRE(activity.ax(k) == ax);
+        }
+    }
+}
+
+TEST_CASE("Text scanner and model loading", "[io]")
+{
+    const std::string text = "# comment\n  -12 +7 0 # 3\n1\t2.5e3\r\n"
+        "-0.125 1e-3 123456789012345678901234 .5 x";
+    mitm::text_scanner scanner(text.data(), text.data() + text.size());
+
+    REQUIRE(scanner.next_integer<int>() == -12);
+    REQUIRE(scanner.next_integer<mitm::index>() == 7);
+    REQUIRE(scanner.next_bool() == false);
+    REQUIRE(scanner.next_bool() == true);
+    REQUIRE(scanner.line() == 2);
+    REQUIRE(scanner.next_real<double>() == 2500.0);
+    REQUIRE(scanner.next_real<float>() == -0.125f);
+    REQUIRE(scanner.next_real<double>() == 1e-3);
+    REQUIRE(scanner.next_real<double>() == 123456789012345678901234.0);
+    REQUIRE(scanner.next_real<float>() == 0.5f);
+
+    try {
+        scanner.next_real<float>();
+        FAIL("io_error expected");
+    } catch (const mitm::io_error &e) {
+        REQUIRE(e.line() == 3);
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1e6, 1e6);
+    for (int i = 0; i != 1000; ++i) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", dist(gen));
+        mitm::text_scanner number(buffer, buffer + std::strlen(buffer));
+
+        REQUIRE(number.next_real<float>() == std::strtof(buffer, nullptr));
+    }
+
+    // Near the midpoint of two floats, a double rounded again to float may
+    // be 1 ulp off.
+    std::uniform_real_distribution<float> unit(1, 10);
+    for (int i = 0; i != 1000; ++i) {
+        const float lower = unit(gen);
+        const float upper = std::nextafter(lower, 11.0f);
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.15e",
+                      (static_cast<double>(lower) + upper) / 2);
+
+        if (i == 0)
+            std::strcpy(buffer, "7.527901887893677e+00");
+
+        mitm::text_scanner number(buffer, buffer + std::strlen(buffer));
+        REQUIRE(number.next_real<float>() == std::strtof(buffer, nullptr));
+
+        mitm::text_scanner twice(buffer, buffer + std::strlen(buffer));
+        REQUIRE(twice.next_real<double>() == std::strtod(buffer, nullptr));
+    }
+
+    // A 2 x 3 model: the rows of A are read with the stride n.
+    const std::string model = "2 3 # m n\n1 0 1\n0 1 1\n1 2\n0.5 -1 3\n";
+    const std::string filename = "mitm-internal-model.txt";
+    std::ofstream(filename) << "0\n" << model;
+
+    mitm::SimpleState loaded, streamed;
+    mitm::load(filename, loaded);
+    std::istringstream iss(model);
+    iss >> streamed;
+
+    REQUIRE(loaded.a == std::vector<bool>({ 1, 0, 1, 0, 1, 1 }));
+    REQUIRE(loaded.a == streamed.a);
+    REQUIRE(loaded.b == std::vector<int>({ 1, 2 }));
+    REQUIRE(loaded.c == std::vector<mitm::real>({ 0.5, -1, 3 }));
+
+    std::ofstream(filename) << "0\n2 3\n1 0 1\n0 2 1\n";
+    try {
+        mitm::load(filename, loaded);
+        FAIL("io_error expected");
+    } catch (const mitm::io_error &e) {
+        REQUIRE(e.line() == 3);
+    }
+
+    std::remove(filename.c_str());
+    REQUIRE_THROWS_AS(mitm::load(filename, loaded), mitm::io_error);
+}
+
+TEST_CASE("Sparse text formats", "[io]")
+{
+    // The same 2 x 3 model in the three formats.
+    const std::string filename = "mitm-internal-sparse.txt";
+    const std::vector<std::string> models = {
+        "0\n2 3\n1 0 1\n0 1 1\n1 1\n0.5 -1 3\n",
+        "1 # rows\n2 3\n2 0 2\n2 1 2\n1 1\n0.5 -1 3\n",
+        "2 # triplets\n2 3\n5\n1 1 1\n0 0 1\n0 1 0\n1 2 1\n0 2 1\n"
+        "1 1\n0.5 -1 3\n" };
+
+    for (const auto &model : models) {
+        std::ofstream(filename) << model;
+
+        mitm::SparseState sparse;
+        mitm::load(filename, sparse);
+
+        REQUIRE(sparse.nonzeros() == 4);
+        REQUIRE(sparse.rows_ptr == std::vector<mitm::index>({ 0, 2, 4 }));
+        REQUIRE(sparse.cols_index ==
+                std::vector<mitm::index>({ 0, 2, 1, 2 }));
+        REQUIRE(sparse.values.empty());
+        REQUIRE(sparse.b == std::vector<int>({ 1, 1 }));
+        REQUIRE(sparse.c == std::vector<mitm::real>({ 0.5, -1, 3 }));
+
+        mitm::SimpleState dense;
+        mitm::load(filename, dense);
+        REQUIRE(dense.a == std::vector<bool>({ 1, 0, 1, 0, 1, 1 }));
+    }
+
+    std::ofstream(filename) << "2\n2 3\n2\n0 0 -1\n1 1 1\n1 1\n1 1 1\n";
+    mitm::SparseState sparse;
+    mitm::load(filename, sparse);
+    REQUIRE(sparse.values == std::vector<int>({ -1, 1 }));
+
+    mitm::SimpleState dense;
+    REQUIRE_THROWS_AS(mitm::load(filename, dense), mitm::io_error);
+
+    std::ofstream(filename)
+        << "2\n2 3\n3\n0 1 1\n1 1 1\n0 1 1\n1 1\n1 1 1\n";
+    try {
+        mitm::load(filename, sparse);
+        FAIL("io_error expected");
+    } catch (const mitm::io_error &e) {
+        REQUIRE(e.line() == 5);
+    }
+
+    std::ofstream(filename) << "1\n2 3\n1 3\n1 0\n1 1\n1 1 1\n";
+    REQUIRE_THROWS_AS(mitm::load(filename, sparse), mitm::io_error);
+
+    std::ofstream(filename) << "3\n2 3\n";
+    REQUIRE_THROWS_AS(mitm::load(filename, sparse), mitm::io_error);
+
+    // The examples of the help text: the second row of the format 0 model
+    // selects all the variables of the first one.
+    const std::vector<std::pair<std::string, std::vector<bool>>> examples = {
+        { "0\n2 3\n1 0 0\n1 1 1\n1 1\n27.3 48.1 0.19\n", { 1, 0, 0 } },
+        { "1\n2 3\n1 0\n2 1 2\n1 1\n27.3 48.1 0.19\n", { 1, 0, 1 } } };
+
+    for (const auto &example : examples) {
+        std::ofstream(filename) << example.first;
+        mitm::load(filename, sparse);
+
+        for (const auto impl : { "", "parallel" }) {
+            const mitm::result r = mitm::heuristic_algorithm(
+                sparse, mitm::options(100, mitm::parameters(), impl));
+
+            REQUIRE(r.status == mitm::result_status::success);
+            REQUIRE(r.x == example.second);
+        }
+    }
+
+    // The assignment problem of the heuristic test, through the compressed
+    // rows of a SparseState and through the dense state.
+    const mitm::index size = 4;
+    std::ofstream ofs(filename);
+    ofs << "1\n" << 2 * size << ' ' << size * size << '\n';
+    for (mitm::index i = 0; i != size; ++i) {
+        ofs << size;
+        for (mitm::index j = 0; j != size; ++j)
+            ofs << ' ' << i * size + j;
+        ofs << '\n';
+    }
+    for (mitm::index j = 0; j != size; ++j) {
+        ofs << size;
+        for (mitm::index i = 0; i != size; ++i)
+            ofs << ' ' << i * size + j;
+        ofs << '\n';
+    }
+    for (mitm::index i = 0; i != 2 * size; ++i)
+        ofs << "1 ";
+    ofs << '\n';
+    for (mitm::index i = 0; i != size; ++i)
+        for (mitm::index j = 0; j != size; ++j)
+            ofs << (5 * i + 3 * j) % 16 << ' ';
+    ofs << '\n';
+    ofs.close();
+
+    mitm::load(filename, sparse);
+    mitm::load(filename, dense);
+    std::remove(filename.c_str());
+
+    const mitm::options o(1000, mitm::parameters(0.1, 0.01, 0.5));
+    const mitm::result from_sparse = mitm::heuristic_algorithm(sparse, o);
+    const mitm::result from_dense = mitm::heuristic_algorithm(dense, o);
+
+    REQUIRE(from_sparse.status == mitm::result_status::success);
+    REQUIRE(from_sparse.x == from_dense.x);
+    REQUIRE(from_sparse.loop == from_dense.loop);
+    REQUIRE(from_sparse.value == from_dense.value);
+}
+
+TEST_CASE("Binary model format", "[io]")
+{
+    const std::string text = "mitm-internal-binary.txt";
+    const std::string binary = "mitm-internal-binary.mitm";
+
+    std::ofstream(text) << "2\n3 4\n5\n2 3 1\n0 0 1\n1 2 -1\n0 1 1\n"
+        "1 3 1\n1 0 1\n0.5 -1 3 2\n";
+
+    mitm::SparseState sparse;
+    mitm::load(text, sparse);
+    mitm::save(binary, sparse);
+
+    REQUIRE(mitm::is_binary_model(binary));
+    REQUIRE(not mitm::is_binary_model(text));
+    REQUIRE_THROWS_AS(mitm::MappedState(text), mitm::io_error);
+
+    {
+        mitm::MappedState mapped(binary);
+        const mitm::csr_view view = mapped.view();
+
+        REQUIRE(mapped.verify());
+        REQUIRE(view.rows == 3);
+        REQUIRE(view.cols == 4);
+        REQUIRE(mapped.nonzeros() == 5);
+        REQUIRE(std::equal(sparse.rows_ptr.begin(), sparse.rows_ptr.end(),
+                           view.rows_ptr));
+        REQUIRE(std::equal(sparse.cols_index.begin(),
+                           sparse.cols_index.end(), view.cols_index));
+        REQUIRE(std::equal(sparse.values.begin(), sparse.values.end(),
+                           view.values));
+        REQUIRE(std::equal(sparse.b.begin(), sparse.b.end(), view.b));
+        REQUIRE(std::equal(sparse.c.begin(), sparse.c.end(), view.c));
+        REQUIRE(reinterpret_cast<std::uintptr_t>(view.cols_index) % 64 == 0);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(view.c) % 64 == 0);
+    }
+
+    // A changed coefficient is seen by the checksum, a truncated file
+    // when the file is opened.
+    {
+        std::fstream fs(binary, std::ios::in | std::ios::out |
+                        std::ios::binary);
+        fs.seekp(64 + 64);
+        fs.put(3);
+    }
+    REQUIRE(not mitm::MappedState(binary).verify());
+
+    {
+        std::ifstream ifs(binary, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(ifs)),
+                          std::istreambuf_iterator<char>());
+        std::ofstream(binary, std::ios::binary | std::ios::trunc)
+            .write(bytes.data(), bytes.size() - 1);
+    }
+    REQUIRE_THROWS_AS(mitm::MappedState(binary), mitm::io_error);
+
+    // The assignment problem gives the same run from the text and the
+    // binary model.
+    const mitm::index size = 4;
+    sparse.init(2 * size, size * size);
+    for (mitm::index i = 0; i != size; ++i) {
+        for (mitm::index j = 0; j != size; ++j)
+            sparse.cols_index.push_back(i * size + j);
+        sparse.rows_ptr[i + 1] = sparse.nonzeros();
+    }
+    for (mitm::index j = 0; j != size; ++j) {
+        for (mitm::index i = 0; i != size; ++i)
+            sparse.cols_index.push_back(i * size + j);
+        sparse.rows_ptr[size + j + 1] = sparse.nonzeros();
+    }
+    std::fill(sparse.b.begin(), sparse.b.end(), 1);
+    for (mitm::index i = 0; i != size; ++i)
+        for (mitm::index j = 0; j != size; ++j)
+            sparse.c[i * size + j] = (5 * i + 3 * j) % 16;
+
+    mitm::save(binary, sparse);
+    mitm::MappedState mapped(binary);
+
+    const mitm::options o(1000, mitm::parameters(0.1, 0.01, 0.5));
+    const mitm::result from_sparse = mitm::heuristic_algorithm(sparse, o);
+    const mitm::result from_mapped =
+        mitm::heuristic_algorithm(mapped.view(), o);
+
+    REQUIRE(from_mapped.status == mitm::result_status::success);
+    REQUIRE(from_mapped.x == from_sparse.x);
+    REQUIRE(from_mapped.loop == from_sparse.loop);
+
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+}
+
+TEST_CASE("Coefficients other than 1", "[heuristic]")
+{
+    // 2 x0 + x1 = 2 and x2 = 1, then 2 x0 + 2 x1 = 2: feasible models but a
+    // row of the classic engines selects b_k variables, whatever their
+    // coefficients.
+    const std::string text = "mitm-internal-values.txt";
+
+    for (const char *model : { "2\n2 3\n3\n0 0 2\n0 1 1\n1 2 1\n"
+                               "2 1\n1 2 3\n",
+                               "2\n1 2\n2\n0 0 2\n0 1 2\n2\n1 1\n" }) {
+        std::ofstream(text) << model;
+
+        mitm::SparseState s;
+        mitm::load(text, s);
+        REQUIRE(not s.values.empty());
+
+        for (const char *impl : { "", "parallel", "portfolio" }) {
+            const mitm::options o(100, mitm::parameters(), impl);
+            REQUIRE_THROWS(mitm::heuristic_algorithm(s, o));
+            REQUIRE_THROWS(mitm::heuristic_algorithm(s.view(), o));
+        }
+
+        mitm::solver solver;
+        std::vector<std::uint8_t> x(s.variables());
+        REQUIRE_THROWS(solver.solve(s.view(), mitm::options(), x.data()));
+    }
+
+    std::remove(text.c_str());
+}
+
+TEST_CASE("MPS and LP readers", "[io]")
+{
+    // The same 2 x 2 assignment problem in the two formats.
+    const std::string mps = "mitm-internal-model.mps";
+    const std::string lp = "mitm-internal-model.lp";
+
+    std::ofstream(mps) << "* assignment\n"
+        "NAME          test\n"
+        "ROWS\n"
+        " N  COST\n"
+        " E  R0\n"
+        " E  R1\n"
+        " E  C0\n"
+        " N  FREE\n"
+        " E  C1\n"
+        "COLUMNS\n"
+        "    MARKER    'MARKER'    'INTORG'\n"
+        "    X00       COST   1    R0   1\n"
+        "    X00       C0     1    FREE 3\n"
+        "    X01       COST   5    R0   1\n"
+        "    X01       C1     1\n"
+        "    X10       COST   4    R1   1\n"
+        "    X10       C0     1\n"
+        "    X11       COST   1    R1   1\n"
+        "    X11       C1     1\n"
+        "RHS\n"
+        "    RHS       R0     1    R1   1\n"
+        "    RHS       C0     1    C1   1\n"
+        "BOUNDS\n"
+        " BV BND       X00\n"
+        " UP BND       X01    1\n"
+        "ENDATA\n";
+
+    std::ofstream(lp) << "\\ assignment\n"
+        "Minimize\n"
+        " cost: x00 + 5 x01 + 4 x10 + x11\n"
+        "Subject To\n"
+        " r0: x00 + x01 = 1\n"
+        " r1: x10 + x11 = 1\n"
+        " c0: x00 + x10 = 1\n"
+        " c1: x01\n"
+        "     + x11 = 1\n"
+        "Bounds\n"
+        " 0 <= x00 <= 1\n"
+        " x01 <= 1\n"
+        "Binary\n"
+        " x00 x01 x10 x11\n"
+        "End\n";
+
+    mitm::SparseState from_mps, from_lp;
+    mitm::load_mps(mps, from_mps);
+    mitm::load_lp(lp, from_lp);
+
+    for (const mitm::SparseState *s : { &from_mps, &from_lp }) {
+        REQUIRE(s->constraints() == 4);
+        REQUIRE(s->variables() == 4);
+        REQUIRE(s->rows_ptr == std::vector<mitm::index>({ 0, 2, 4, 6, 8 }));
+        REQUIRE(s->cols_index ==
+                std::vector<mitm::index>({ 0, 1, 2, 3, 0, 2, 1, 3 }));
+        REQUIRE(s->values.empty());
+        REQUIRE(s->b == std::vector<int>({ 1, 1, 1, 1 }));
+        REQUIRE(s->bounds.empty());
+        REQUIRE(s->c == std::vector<mitm::real>({ 1, 5, 4, 1 }));
+    }
+
+    const mitm::result r = mitm::heuristic_algorithm(from_lp,
+                                                      mitm::options(100));
+    REQUIRE(r.status == mitm::result_status::success);
+    REQUIRE(r.x == std::vector<bool>({ 1, 0, 0, 1 }));
+
+    // Inequalities and negative coefficients give the bounds of the rows.
+    std::ofstream(lp) << "Maximize\n"
+        " - x - 2 y - z\n"
+        "st\n"
+        " a: x + y - z <= 1\n"
+        " -2 <= x - y + 2 x <= 2\n"
+        " c: 3 y >= -1\n"
+        "End\n";
+
+    mitm::SparseState bounded;
+    mitm::load_lp(lp, bounded);
+
+    REQUIRE(bounded.rows_ptr == std::vector<mitm::index>({ 0, 3, 5, 6 }));
+    REQUIRE(bounded.values == std::vector<int>({ 1, 1, -1, 3, -1, 3 }));
+    REQUIRE(bounded.c == std::vector<mitm::real>({ 1, 2, 1 }));
+    REQUIRE(bounded.bounds.size() == 3);
+    REQUIRE(bounded.bounds[0].upper_bound == 1);
+    REQUIRE(bounded.bounds[0].lower_bound ==
+            -std::numeric_limits<mitm::real>::infinity());
+    REQUIRE(bounded.bounds[1].lower_bound == -2);
+    REQUIRE(bounded.bounds[1].upper_bound == 2);
+    REQUIRE(bounded.bounds[2].lower_bound == -1);
+
+    // The first assignment, all 0 with these costs, satisfies the bounds.
+    const mitm::result zero = mitm::heuristic_algorithm(bounded,
+                                                         mitm::options(10));
+    REQUIRE(zero.status == mitm::result_status::success);
+    REQUIRE(zero.x == std::vector<bool>({ 0, 0, 0 }));
+
+    // The second row has a single reduced cost in its bounds.
+    std::ofstream(lp) << "minimize\n x1 + 2 x2 + 3 x3\n"
+        "subject to\n c1: x1 + x2 + x3 >= 1\n c2: x1 + x3 <= 1\n"
+        "binary\n x1 x2 x3\nend\n";
+
+    mitm::SparseState single;
+    mitm::load_lp(lp, single);
+    REQUIRE(single.bounds.size() == 2);
+
+    const mitm::result forced = mitm::heuristic_algorithm(single,
+                                                           mitm::options(10));
+    REQUIRE(forced.status == mitm::result_status::success);
+    REQUIRE(forced.x[0] + forced.x[1] + forced.x[2] >= 1);
+    REQUIRE(forced.x[0] + forced.x[2] <= 1);
+
+    // The errors give the line of the file.
+    auto line_of = [](const std::string &filename, bool is_mps) -> int
+        {
+            mitm::SparseState s;
+            try {
+                if (is_mps)
+                    mitm::load_mps(filename, s);
+                else
+                    mitm::load_lp(filename, s);
+            } catch (const mitm::io_error &e) {
+                return e.line();
+            }
+
+            return -1;
+        };
+
+    std::ofstream(mps) << "ROWS\n N COST\n E R0\nCOLUMNS\n"
+        "    X COST 1 R0 1\n    Y R9 1\nENDATA\n";
+    REQUIRE(line_of(mps, true) == 5);
+
+    std::ofstream(mps) << "ROWS\n E R0\nCOLUMNS\n    X R0 1\n"
+        "BOUNDS\n UP BND X 4\nENDATA\n";
+    REQUIRE(line_of(mps, true) == 5);
+
+    std::ofstream(lp) << "min\n x + y\nst\n\n x + 0.5 y = 1\nend\n";
+    REQUIRE(line_of(lp, false) == 4);
+
+    std::ofstream(lp) << "min\n x\nst\n x = 1\ngeneral\n x\nend\n";
+    REQUIRE(line_of(lp, false) == 4);
+
+    std::remove(mps.c_str());
+    std::remove(lp.c_str());
+}
+
+TEST_CASE("Parallel chunked readers", "[io]")
+{
+    // A model read in one chunk and in chunks of a few bytes gives the same
+    // state and the same errors.
+    const mitm::chunk_policy sequential(1, 1u << 30);
+    const mitm::chunk_policy chunked(4, 16);
+    const std::string text = "mitm-internal-chunks.txt";
+    const std::string mps = "mitm-internal-chunks.mps";
+    const mitm::index m = 12, n = 40;
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    std::vector<std::vector<mitm::index>> rows(m);
+    for (mitm::index j = 0; j != n; ++j)
+        for (mitm::index k = 0; k != m; ++k)
+            if (dist(gen) == 0)
+                rows[k].push_back(j);
+
+    // The three formats with an optional error on the line @e error.
+    auto write = [&](int format, int error)
+        {
+            std::vector<std::string> lines;
+            std::ostringstream os;
+
+            if (format == 3) {
+                lines.push_back("ROWS");
+                lines.push_back(" N COST");
+                for (mitm::index k = 0; k != m; ++k)
+                    lines.push_back(" E R" + std::to_string(k));
+                lines.push_back("COLUMNS");
+                for (mitm::index j = 0; j != n; ++j) {
+                    lines.push_back("* column " + std::to_string(j));
+                    lines.push_back("    X" + std::to_string(j) + " COST " +
+                                    std::to_string(j % 7));
+                    for (mitm::index k = 0; k != m; ++k)
+                        if (std::count(rows[k].begin(), rows[k].end(), j))
+                            lines.push_back("    X" + std::to_string(j) +
+                                            " R" + std::to_string(k) +
+                                            " 1");
+                }
+                lines.push_back("RHS");
+                for (mitm::index k = 0; k != m; ++k)
+                    lines.push_back("    RHS R" + std::to_string(k) + " 1");
+                lines.push_back("ENDATA");
+            } else {
+                lines.push_back(std::to_string(format));
+                lines.push_back(std::to_string(m) + ' ' + std::to_string(n));
+                if (format == 2) {
+                    mitm::index nnz = 0;
+                    for (const auto &row : rows)
+                        nnz += static_cast<mitm::index>(row.size());
+                    lines.push_back(std::to_string(nnz));
+                }
+                for (mitm::index k = 0; k != m; ++k) {
+                    os.str("");
+                    if (format == 1)
+                        os << rows[k].size();
+                    for (mitm::index j : rows[k])
+                        os << (format == 1 ? " " : "\n") <<
+                            (format == 2 ? std::to_string(k) + ' ' : "") <<
+                            j << (format == 2 ? " 1" : "");
+                    const std::string row = os.str();
+                    lines.push_back(format == 2 ? row.substr(1) : row);
+                }
+                os.str("");
+                for (mitm::index k = 0; k != m; ++k)
+                    os << "1 ";
+                lines.push_back(os.str());
+                os.str("");
+                for (mitm::index j = 0; j != n; ++j)
+                    os << j % 7 << ".5 ";
+                lines.push_back(os.str());
+            }
+
+            const char *errors[2][3] = {
+                { "1 x 2", "1 99999999999 2", "" },
+                { "    X0 R1 0.5", "    X1 R0 1 R0 1", "    X1 R0" } };
+
+            if (error >= 0)
+                lines[error] = errors[format == 3][error / 3 % 3];
+
+            std::ofstream ofs(format == 3 ? mps : text);
+            for (const auto &line : lines)
+                ofs << line << '\n';
+
+            return static_cast<int>(lines.size());
+        };
+
+    auto read = [&](int format, const mitm::chunk_policy &policy,
+                    mitm::SparseState &s) -> std::string
+        {
+            try {
+                if (format == 3)
+                    mitm::load_mps(mps, s, policy);
+                else
+                    mitm::load(text, s, policy);
+            } catch (const mitm::io_error &e) {
+                return e.what();
+            }
+
+            return std::string();
+        };
+
+    for (int format = 1; format <= 3; ++format) {
+        const int size = write(format, -1);
+
+        mitm::SparseState first, second;
+        REQUIRE(read(format, sequential, first).empty());
+        REQUIRE(read(format, chunked, second).empty());
+        REQUIRE(first.rows_ptr == second.rows_ptr);
+        REQUIRE(first.cols_index == second.cols_index);
+        REQUIRE(first.b == second.b);
+        REQUIRE(first.c == second.c);
+
+        for (int error = 2; error < size - 1; error += 3) {
+            write(format, error);
+
+            const std::string expected = read(format, sequential, first);
+            REQUIRE(read(format, chunked, second) == expected);
+        }
+    }
+
+    std::remove(text.c_str());
+    std::remove(mps.c_str());
+}
+
+TEST_CASE("Buffered cstream", "[io]")
+{
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    auto content = [file]() -> std::string
+        {
+            std::string ret;
+            std::rewind(file);
+            for (int c; (c = std::fgetc(file)) != EOF; )
+                ret.push_back(static_cast<char>(c));
+
+            return ret;
+        };
+
+    {
+        mitm::cstream cs(fileno(file));
+
+        // A regular file is written by flush() or when the buffer is full.
+        cs << "value: " << 42 << ' ' << 'x' << '\n';
+        REQUIRE(content().empty());
+
+        cs.flush();
+        REQUIRE(content() == "value: 42 x\n");
+
+        const std::string large(20000, 'a');
+        cs << large;
+        REQUIRE(content().size() == 12 + large.size());
+
+        cs << "end";
+    }
+
+    REQUIRE(content().size() == 12 + 20000 + 3);
+    std::fclose(file);
+}
+
+TEST_CASE("Numeric formatting of cstream", "[io]")
+{
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    // The numbers are written as std::to_string(), the reals as "%f".
+    std::string expected;
+    std::vector<double> reals = {
+        0.0, -0.0, 1.0, -1.5, 0.0078125, 0.0234375, 0.9999995, 1e-7,
+        -4e-7, 123456.5, 9007199254740993.0, 1e19, 1.8446744073709552e19,
+        1e300, std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN() };
+
+    std::mt19937_64 gen(7);
+    std::uniform_real_distribution<double> exponent(-30, 30);
+    for (int i = 0; i != 2000; ++i) {
+        const double value = std::pow(10.0, exponent(gen));
+        reals.push_back(i % 2 ? value : -value);
+    }
+
+    {
+        mitm::cstream cs(fileno(file));
+
+        for (long long value : { 0ll, 7ll, -42ll, 100ll,
+                    std::numeric_limits<long long>::min(),
+                    std::numeric_limits<long long>::max() }) {
+            cs << value << ' ';
+            expected += std::to_string(value) + ' ';
+        }
+
+        cs << std::numeric_limits<unsigned long long>::max() << ' '
+           << std::numeric_limits<int>::min() << ' ' << 12345u << ' ';
+        expected += std::to_string(
+            std::numeric_limits<unsigned long long>::max()) + ' ' +
+            std::to_string(std::numeric_limits<int>::min()) + " 12345 ";
+
+        char buffer[400];
+        for (double value : reals) {
+            cs << value << ' ' << static_cast<float>(value) << '\n';
+            std::snprintf(buffer, sizeof(buffer), "%f %f\n", value,
+                          static_cast<double>(static_cast<float>(value)));
+            expected += buffer;
+        }
+
+        cs.printf("%s %d\n", "printf", 10);
+        cs.printf("%s\n", std::string(10000, 'p').c_str());
+        expected += "printf 10\n" + std::string(10000, 'p') + '\n';
+    }
+
+    std::string content;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF; )
+        content.push_back(static_cast<char>(c));
+    std::fclose(file);
+
+    REQUIRE(content == expected);
+}